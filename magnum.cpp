@@ -3,15 +3,139 @@
 #include <streambuf>
 
 #include "src/virtual-machine.hpp"
+#include "src/emitter.hpp"
+#include "src/cache.hpp"
 
-void execute(std::string path) {
+bool cache = true, stats = false;
+std::string image, snapshot, statistics, profile, trace;
+
+std::string_view map(std::string path) {
+    #ifdef CACHE_MMAP
+    int file = open(path.c_str(), O_RDONLY);
+    if(file == -1) return "";
+
+    struct stat status;
+    void* memory = MAP_FAILED;
+
+    if(fstat(file, &status) == 0 && status.st_size > 0) memory = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+
+    if(memory == MAP_FAILED) return "";
+
+    return std::string_view((const char*)memory, status.st_size);
+    #else
     std::ifstream file(path);
-    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string* source = new std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    return *source;
+    #endif
+}
+
+void execute(std::string path) {
+    std::string_view source = map(path);
 
-    VM::Interpret result = VM().interpret(source);
+    VM vm; Function* script = nullptr;
+    uint64_t hash = Cache::hash(source);
+
+    if(image.empty() == false && vm.restore(image) == false) { fprintf(stderr, "Cannot restore the image `%s`\n", image.c_str()); exit(74); }
+
+    if(cache) script = Cache::load(path + "c", hash);
+
+    if(script == nullptr) {
+        script = vm.compile(source.data(), source.size());
+        if(script == NULL) exit(65);
+
+        if(cache && source.empty() == false) Cache::store(path + "c", hash, script);
+    }
+
+    VM::Interpret result = vm.interpret(script);
 
     if(result == VM::Interpret::INTERPRET_COMPILE_ERROR) exit(65);
     if(result == VM::Interpret::INTERPRET_RUNTIME_ERROR) exit(70);
+
+    if(snapshot.empty() == false && vm.snapshot(snapshot) == false) { fprintf(stderr, "Cannot write the image `%s`\n", snapshot.c_str()); exit(74); }
+}
+
+void emit(std::string path) {
+    std::ifstream file(path);
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    Parser::LAZY = false;
+
+    Parser parser; Function* script = parser.compile(source);
+    if(script == NULL) exit(65);
+
+    std::cout << Emitter().emit(script);
+}
+
+int depth(const std::string& input) {
+    Tokenizer tokenizer(input.data(), input.size());
+    int depth = 0;
+
+    for(Token token = tokenizer.next(); token.type != END_OF_FILE && token.type != ERROR; token = tokenizer.next())
+        depth += (token.type == OPEN_BRACES) - (token.type == CLOSE_BRACES);
+
+    return depth;
+}
+
+void repl() {
+    VM vm; std::string line, input; 
+
+    printf("> "); fflush(stdout);
+
+    while(std::getline(std::cin, line)) {
+        input += line + "\n";
+
+        if(depth(input) > 0) { printf("... "); fflush(stdout); continue; }
+
+        if(vm.interpret(input) == VM::Interpret::INTERPRET_RUNTIME_ERROR) fprintf(stderr, "\n");
+
+        input.clear();
+
+        printf("> "); fflush(stdout);
+    }
+
+    printf("\n");
 }
 
-int main(int argc, char* argv[]) { if(argc == 2) { std::string file = std::string(argv[1]); execute(file); } }
\ No newline at end of file
+int main(int argc, char* argv[]) { 
+    std::string file; bool cpp = false;
+
+    for(int i = 1; i < argc; i++) {
+        std::string argument = std::string(argv[i]);
+
+        if(argument == "--lazy") Parser::LAZY = true;
+        else if(argument == "--jit") JIT::ENABLED = true;
+        else if(argument == "--registers") Registers::ENABLED = true;
+        else if(argument == "--emit-cpp") cpp = true;
+        else if(argument == "--no-cache") cache = false;
+        else if(argument == "--image" && i + 1 < argc) image = argv[++i];
+        else if(argument == "--snapshot" && i + 1 < argc) snapshot = argv[++i];
+        else if(argument == "--gc-threshold" && i + 1 < argc) Heap::THRESHOLD = strtoull(argv[++i], nullptr, 10);
+        else if(argument == "--gc-growth" && i + 1 < argc) Heap::GROWTH = strtod(argv[++i], nullptr);
+        else if(argument == "--gc-stats") Heap::STATISTICS = true;
+        else if(argument == "--stats") Statistics::ENABLED = stats = true;
+        else if(argument == "--stats-json" && i + 1 < argc) { Statistics::ENABLED = true; statistics = argv[++i]; }
+        else if(argument == "--profile" && i + 1 < argc) { Profiler::ENABLED = true; profile = argv[++i]; }
+        else if(argument == "--profile-interval" && i + 1 < argc) Profiler::INTERVAL = atoi(argv[++i]);
+        else if(argument == "--trace" && i + 1 < argc) { Tracer::ENABLED = true; trace = argv[++i]; }
+        else if(argument == "--memory" && i + 1 < argc) { Allocations::ENABLED = true; Allocations::PATH = argv[++i]; }
+        else if(argument == "--memory-sample" && i + 1 < argc) Allocations::SAMPLE = std::max(1, atoi(argv[++i]));
+        else if(argument == "--memory-interval" && i + 1 < argc) Allocations::INTERVAL = std::max(0, atoi(argv[++i]));
+        else file = argument;
+    }
+
+    if(Heap::STATISTICS) atexit([]() { Heap::report(mnemonics, sizeof(mnemonics) / sizeof(mnemonics[0])); });
+
+    if(Statistics::ENABLED) atexit([]() {
+        if(stats) fputs(Statistics::text().c_str(), stderr);
+        if(statistics.empty() == false) std::ofstream(statistics) << Statistics::json();
+    });
+
+    if(Profiler::ENABLED) atexit([]() { Profiler::report(profile); });
+    if(Tracer::ENABLED) atexit([]() { if(Tracer::write(trace) == false) fprintf(stderr, "Cannot write the trace `%s`\n", trace.c_str()); });
+
+    if(file.empty()) { repl(); return 0; }
+
+    if(cpp) emit(file); else execute(file); 
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef ALLOCATIONS_H
+#define ALLOCATIONS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+
+class Allocations {
+    public:
+        static bool ENABLED, COUNTING;
+        static size_t SAMPLE, INTERVAL;
+        static std::string PATH;
+
+        typedef enum { STRING, NUMBER, CHUNK } Kind;
+
+        typedef struct {
+            Kind kind;
+            std::string function;
+            int line;
+            size_t allocations, allocated, count, live;
+        } Site;
+
+        static void (*locate)(std::string* function, int* line);
+
+        static uint32_t allocate(Kind kind, size_t size) {
+            if(--Allocations::countdown > 0) return 0;
+            Allocations::countdown = Allocations::SAMPLE;
+
+            std::string function = "(outside the interpreter)"; int line = 0;
+            if(Allocations::locate != nullptr) Allocations::locate(&function, &line);
+
+            auto key = std::make_tuple(kind, function, line);
+            auto entry = Allocations::indexes.find(key);
+
+            if(entry == Allocations::indexes.end()) {
+                entry = Allocations::indexes.insert({ key, (uint32_t)Allocations::sites.size() }).first;
+                Allocations::sites.push_back({ kind, function, line, 0, 0, 0, 0 });
+            }
+
+            Site* site = &Allocations::sites[entry->second];
+            site->allocations++; site->allocated += size;
+            if(kind != NUMBER) { site->count++; site->live += size; }
+
+            return entry->second;
+        }
+
+        static void release(uint32_t site, size_t size) { Allocations::sites[site].count--; Allocations::sites[site].live -= size; }
+
+        static bool due() { return Allocations::INTERVAL > 0 && ++Allocations::collections % Allocations::INTERVAL == 0; }
+
+        static bool dump(std::string label, std::vector<Site> chunks) {
+            FILE* file = fopen(Allocations::PATH.c_str(), Allocations::snapshots == 0 ? "w" : "a");
+            if(file == nullptr) return false;
+
+            std::vector<Site> sites(Allocations::sites.begin() + 1, Allocations::sites.end());
+            for(Site& site : sites) { site.allocations *= Allocations::SAMPLE; site.allocated *= Allocations::SAMPLE; site.count *= Allocations::SAMPLE; site.live *= Allocations::SAMPLE; }
+
+            sites.insert(sites.end(), chunks.begin(), chunks.end());
+            std::sort(sites.begin(), sites.end(), [](Site& left, Site& right) { return left.live > right.live || (left.live == right.live && left.allocated > right.allocated); });
+
+            size_t live = 0;
+            for(Site& site : sites) live += site.live;
+
+            fprintf(file, "# snapshot %zu, %s: %zu bytes live, 1 in %zu allocations sampled\n", ++Allocations::snapshots, label.c_str(), live, Allocations::SAMPLE);
+            fprintf(file, "%-6s %12s %10s %14s %12s %6s  %s\n", "kind", "live bytes", "live", "allocated", "allocations", "line", "function");
+
+            for(Site& site : sites)
+                fprintf(file, "%-6s %12zu %10zu %14zu %12zu %6d  %s\n", kinds[site.kind], site.live, site.count, site.allocated, site.allocations, site.line, site.function.c_str());
+
+            fprintf(file, "\n");
+
+            return fclose(file) == 0;
+        }
+
+    private:
+        static const char* const kinds[];
+
+        static std::vector<Site> sites;
+        static std::map<std::tuple<Kind, std::string, int>, uint32_t> indexes;
+
+        static size_t countdown, collections, snapshots;
+};
+
+bool Allocations::ENABLED = false, Allocations::COUNTING = false;
+size_t Allocations::SAMPLE = 1, Allocations::INTERVAL = 0;
+std::string Allocations::PATH;
+
+void (*Allocations::locate)(std::string* function, int* line) = nullptr;
+
+const char* const Allocations::kinds[] = { "string", "number", "chunk" };
+
+std::vector<Allocations::Site> Allocations::sites = { { Allocations::STRING, "", 0, 0, 0, 0, 0 } };
+std::map<std::tuple<Allocations::Kind, std::string, int>, uint32_t> Allocations::indexes;
+
+size_t Allocations::countdown = 1, Allocations::collections = 0, Allocations::snapshots = 0;
+
+#endif
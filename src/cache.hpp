@@ -0,0 +1,465 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstdio>
+#include <cstdint>
+#include <stdexcept>
+
+#include "common.hpp"
+#include "symbol-table.hpp"
+#include "standard-library.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define CACHE_MMAP
+#endif
+
+#define CACHE_MAGIC 0x4347414d
+#define IMAGE_MAGIC 0x4947414d
+#define CACHE_VERSION 3
+
+class Cache {
+    public:
+        static uint64_t hash(std::string_view source) {
+            uint64_t hash = 0xcbf29ce484222325;
+
+            for(unsigned char character : source) { hash ^= character; hash *= 0x100000001b3; }
+
+            return hash;
+        }
+
+        static Function* load(std::string path, uint64_t hash) {
+            Function* script = nullptr;
+
+            Cache::map(path, [&](Reader* reader) {
+                if(Cache::integer(reader) != CACHE_MAGIC || Cache::integer(reader) != CACHE_VERSION) return;
+                if(Cache::integer(reader) != (uint32_t)hash || Cache::integer(reader) != (uint32_t)(hash >> 32)) return;
+
+                std::vector<Function> functions;
+                if(Cache::functions(reader, &functions) && functions.empty() == false && reader->cursor == reader->end) script = new Function(functions[0]);
+            });
+
+            return script;
+        }
+
+        static bool store(std::string path, uint64_t hash, Function* script) {
+            Writer writer;
+
+            if(Cache::collect(script, &writer) == false) return false;
+
+            Cache::integer(&writer.output, CACHE_MAGIC); Cache::integer(&writer.output, CACHE_VERSION);
+            Cache::integer(&writer.output, (uint32_t)hash); Cache::integer(&writer.output, (uint32_t)(hash >> 32));
+
+            Cache::functions(&writer);
+
+            return Cache::write(path, writer.output);
+        }
+
+        static bool snapshot(std::string path, Table* globals) {
+            Writer writer;
+
+            std::vector<std::pair<std::string, Value>> entries = globals->entries();
+
+            for(auto& entry : entries)
+                if(entry.second.index() == VAL_FUNCTION && Cache::collect(&entry.second.value.function, &writer) == false) return false;
+
+            Cache::integer(&writer.output, IMAGE_MAGIC); Cache::integer(&writer.output, CACHE_VERSION);
+
+            Cache::functions(&writer);
+
+            Cache::integer(&writer.output, entries.size());
+
+            for(auto& entry : entries) {
+                Cache::text(&writer.output, entry.first);
+                if(Cache::value(&writer, entry.second) == false) return false;
+            }
+
+            return Cache::write(path, writer.output);
+        }
+
+        static bool restore(std::string path, Table* globals) {
+            bool restored = false;
+
+            Cache::map(path, [&](Reader* reader) {
+                if(Cache::integer(reader) != IMAGE_MAGIC || Cache::integer(reader) != CACHE_VERSION) return;
+
+                std::vector<Function> functions;
+                if(Cache::functions(reader, &functions) == false) return;
+
+                uint32_t count = Cache::integer(reader);
+                std::vector<std::pair<std::string, Value>> entries;
+
+                for(uint32_t i = 0; i < count && reader->valid; i++) {
+                    std::string name = Cache::text(reader);
+                    Value value;
+
+                    if(Cache::value(reader, &value, functions.size()) == false) break;
+                    if(value.index() == VAL_FUNCTION) value = functions[value.value.integer];
+
+                    entries.push_back({ name, value });
+                }
+
+                if(reader->valid == false || reader->cursor != reader->end) return;
+
+                for(auto& entry : entries)
+                    if(globals->insert(entry.first, entry.second) == false) globals->set(entry.first, entry.second);
+
+                restored = true;
+            });
+
+            return restored;
+        }
+
+    private:
+        typedef struct {
+            uint8_t* cursor, *end;
+            bool valid;
+        } Reader;
+
+        typedef struct {
+            std::string output;
+            std::vector<Function*> functions;
+            std::map<Chunk*, uint32_t> indexes;
+        } Writer;
+
+        typedef struct {
+            Chunk* chunk;
+            uint32_t slot, index;
+        } Link;
+
+        template<typename CALLBACK>
+        static void map(std::string path, CALLBACK callback) {
+            #ifdef CACHE_MMAP
+            int file = open(path.c_str(), O_RDONLY);
+            if(file == -1) return;
+
+            struct stat status;
+            if(fstat(file, &status) == -1 || status.st_size == 0) { close(file); return; }
+
+            void* memory = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            close(file);
+
+            if(memory == MAP_FAILED) return;
+
+            Reader reader = { (uint8_t*)memory, (uint8_t*)memory + status.st_size, true };
+            callback(&reader);
+
+            munmap(memory, status.st_size);
+            #else
+            FILE* file = fopen(path.c_str(), "rb");
+            if(file == nullptr) return;
+
+            std::vector<uint8_t> buffer;
+            uint8_t block[4096]; size_t size;
+
+            while((size = fread(block, 1, sizeof(block), file)) > 0) buffer.insert(buffer.end(), block, block + size);
+            fclose(file);
+
+            Reader reader = { buffer.data(), buffer.data() + buffer.size(), true };
+            callback(&reader);
+            #endif
+        }
+
+        static bool write(std::string path, const std::string& output) {
+            std::string temporary = path + ".tmp";
+
+            FILE* file = fopen(temporary.c_str(), "wb");
+            if(file == nullptr) return false;
+
+            bool written = fwrite(output.data(), 1, output.size(), file) == output.size();
+            written = fclose(file) == 0 && written;
+
+            if(written == false || rename(temporary.c_str(), path.c_str()) != 0) { remove(temporary.c_str()); return false; }
+
+            return true;
+        }
+
+        static bool collect(Function* function, Writer* writer) {
+            if(writer->indexes.count(function->chunk)) return true;
+            if(function->chunk->lazy != nullptr) return false;
+
+            writer->indexes[function->chunk] = writer->functions.size();
+            writer->functions.push_back(function);
+
+            for(Value& value : function->chunk->values) {
+                if(value.index() != VAL_FUNCTION && value.index() != VAL_NUMBER && value.index() != VAL_STRING) return false;
+                if(value.index() == VAL_FUNCTION && Cache::collect(&value.value.function, writer) == false) return false;
+            }
+
+            return true;
+        }
+
+        static void integer(std::string* output, uint32_t value) {
+            for(int i = 0; i < 4; i++) *output += (char)((value >> (i * 8)) & 0xff);
+        }
+
+        static void text(std::string* output, const std::string& text) {
+            Cache::integer(output, text.size());
+            *output += text;
+        }
+
+        static bool value(Writer* writer, Value value) {
+            writer->output += (char)value.index();
+
+            switch(value.index()) {
+                case VAL_NUMBER: Cache::text(&writer->output, value.value.number.get()); return true;
+                case VAL_STRING: Cache::text(&writer->output, value.value.string.get()); return true;
+                case VAL_BOOLEAN: writer->output += (char)value.value.boolean.boolean; return true;
+                case VAL_VOID: return true;
+
+                case VAL_INTEGER: writer->output.back() = (char)VAL_NUMBER; Cache::text(&writer->output, Number::INTEGER(value.value.integer).get()); return true;
+
+                case VAL_FUNCTION: Cache::integer(&writer->output, writer->indexes[value.value.function.chunk]); return true;
+
+                case VAL_NATIVE:
+                    for(size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); i++)
+                        if(natives[i].native == value.value.native) { Cache::integer(&writer->output, i); return true; }
+
+                    return false;
+            }
+
+            return false;
+        }
+
+        static void functions(Writer* writer) {
+            Cache::integer(&writer->output, writer->functions.size());
+
+            for(Function* function : writer->functions) {
+                Chunk* chunk = function->chunk;
+
+                Cache::text(&writer->output, function->name);
+                Cache::integer(&writer->output, function->parameters);
+                Cache::integer(&writer->output, function->memo != nullptr);
+
+                Cache::integer(&writer->output, chunk->codes.size());
+                writer->output.append((char*)chunk->codes.data(), chunk->codes.size());
+
+                Cache::integer(&writer->output, chunk->lines.runs.size());
+                for(size_t k = 0; k < chunk->lines.runs.size(); k++) { Cache::integer(&writer->output, chunk->lines.length(k)); Cache::integer(&writer->output, chunk->lines.runs[k].line); }
+
+                Cache::integer(&writer->output, chunk->values.size());
+                for(Value& value : chunk->values) Cache::value(writer, value);
+            }
+        }
+
+        static uint8_t* bytes(Reader* reader, size_t size) {
+            if(reader->valid == false || (size_t)(reader->end - reader->cursor) < size) { reader->valid = false; return nullptr; }
+
+            uint8_t* bytes = reader->cursor;
+            reader->cursor += size;
+            return bytes;
+        }
+
+        static uint32_t integer(Reader* reader) {
+            uint8_t* bytes = Cache::bytes(reader, 4);
+            if(bytes == nullptr) return 0;
+
+            return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+        }
+
+        static std::string text(Reader* reader) {
+            uint32_t size = Cache::integer(reader);
+
+            uint8_t* bytes = Cache::bytes(reader, size);
+            if(bytes == nullptr) return "";
+
+            return std::string((char*)bytes, size);
+        }
+
+        static bool value(Reader* reader, Value* value, uint32_t functions) {
+            uint8_t* tag = Cache::bytes(reader, 1);
+            if(tag == nullptr) return false;
+
+            switch(*tag) {
+                case VAL_NUMBER: {
+                    std::string number = Cache::text(reader);
+                    if(number.empty()) { reader->valid = false; return false; }
+
+                    try { *value = Number(number); }
+                    catch(std::logic_error&) { reader->valid = false; return false; }
+
+                    return true;
+                }
+
+                case VAL_STRING: *value = String(Cache::text(reader)).intern(); return reader->valid;
+
+                case VAL_BOOLEAN: {
+                    uint8_t* boolean = Cache::bytes(reader, 1);
+                    if(boolean == nullptr) return false;
+
+                    *value = Boolean(*boolean != 0); return true;
+                }
+
+                case VAL_VOID: *value = Void::VOID(); return true;
+
+                case VAL_FUNCTION: {
+                    uint32_t index = Cache::integer(reader);
+                    if(reader->valid == false || index >= functions) { reader->valid = false; return false; }
+
+                    *value = Function(); value->value.integer = index;
+                    return true;
+                }
+
+                case VAL_NATIVE: {
+                    uint32_t index = Cache::integer(reader);
+                    if(reader->valid == false || index >= sizeof(natives) / sizeof(natives[0])) { reader->valid = false; return false; }
+
+                    *value = natives[index].native; return true;
+                }
+            }
+
+            reader->valid = false; return false;
+        }
+
+        static int inputs(Instruction instruction) {
+            switch(instruction.code) {
+                case OP_ADD: case OP_SUBTRACT: case OP_MULTIPLY: case OP_DIVIDE: case OP_MOD: case OP_CONCATENATE: case OP_AND: case OP_OR:
+                case OP_EQUALS: case OP_NOT_EQUALS: case OP_GREATER: case OP_GREATER_EQUALS: case OP_LESS: case OP_LESS_EQUALS:
+                    return 2;
+
+                case OP_PLUS: case OP_MINUS: case OP_NOT: case OP_PRINT: case OP_DECLARATION: case OP_DECLARATION_LONG:
+                case OP_ASSIGNMENT_VARIABLE: case OP_ASSIGNMENT_VARIABLE_LONG: case OP_ASSIGNMENT_LOCAL: case OP_ASSIGNMENT_LOCAL_LONG:
+                case OP_CONDITION: case OP_CONDITION_LONG: case OP_RETURN: case OP_POP:
+                    return 1;
+
+                case OP_CALL: case OP_TAIL_CALL: return instruction.operand + 1;
+            }
+
+            return 0;
+        }
+
+        static bool verify(Function* function) {
+            std::vector<uint8_t>& codes = function->chunk->codes;
+            std::vector<Value>& values = function->chunk->values;
+
+            if(codes.empty() || function->parameters < 0 || function->parameters > UINT8_MAX) return false;
+
+            std::vector<int> depths(codes.size(), -1);
+            uint8_t last = OP_EXIT;
+
+            for(size_t i = 0; i < codes.size(); i += 1 + operands(codes[i])) {
+                if(codes[i] >= sizeof(mnemonics) / sizeof(mnemonics[0]) || i + 1 + operands(codes[i]) > codes.size()) return false;
+                depths[i] = -2; last = codes[i];
+            }
+
+            if(last != OP_EXIT && last != OP_RETURN && last != OP_JUMP && last != OP_JUMP_LONG && last != OP_LOOP && last != OP_LOOP_LONG) return false;
+
+            std::vector<size_t> work = { 0 };
+            depths[0] = function->parameters;
+
+            while(work.empty() == false) {
+                size_t i = work.back(); work.pop_back();
+
+                Instruction instruction = decode(codes, i);
+                int depth = depths[i];
+
+                if(depth < Cache::inputs(instruction)) return false;
+
+                switch(instruction.code) {
+                    case OP_CONSTANT: case OP_CONSTANT_LONG:
+                        if(instruction.operand >= values.size()) return false;
+                        break;
+
+                    case OP_DECLARATION: case OP_DECLARATION_LONG: case OP_VARIABLE: case OP_VARIABLE_LONG:
+                    case OP_ASSIGNMENT_VARIABLE: case OP_ASSIGNMENT_VARIABLE_LONG:
+                        if(instruction.operand >= values.size() || values[instruction.operand].index() != VAL_STRING) return false;
+                        break;
+
+                    case OP_LOCAL: case OP_LOCAL_LONG: case OP_ASSIGNMENT_LOCAL: case OP_ASSIGNMENT_LOCAL_LONG: case OP_COUNTER:
+                        if((int)instruction.operand >= depth) return false;
+                        break;
+
+                    case OP_RANGE: case OP_RANGE_LONG: case OP_RANGE_LOOP: case OP_RANGE_LOOP_LONG:
+                        if((int)instruction.slot + 1 >= depth) return false;
+                        break;
+                }
+
+                depth += effect(instruction);
+                if(depth + 1 > STACK_MAX) return false;
+
+                std::vector<long> successors;
+
+                if(instruction.target != -1) successors.push_back(instruction.target);
+
+                if(instruction.code != OP_JUMP && instruction.code != OP_JUMP_LONG && instruction.code != OP_LOOP && instruction.code != OP_LOOP_LONG &&
+                    instruction.code != OP_RETURN && instruction.code != OP_EXIT) successors.push_back(i + instruction.length);
+
+                for(long successor : successors) {
+                    if(successor < 0 || successor >= (long)codes.size() || depths[successor] == -1) return false;
+
+                    if(depths[successor] == -2) { depths[successor] = depth; work.push_back(successor); }
+                    else if(depths[successor] != depth) return false;
+                }
+            }
+
+            return true;
+        }
+
+        static bool functions(Reader* reader, std::vector<Function>* functions) {
+            uint32_t count = Cache::integer(reader);
+            if(reader->valid == false || count > (size_t)(reader->end - reader->cursor)) return false;
+
+            functions->resize(count);
+            std::vector<Link> links;
+
+            for(Function& function : *functions) function.chunk = new Chunk();
+
+            for(uint32_t i = 0; i < count && reader->valid; i++) {
+                Function* function = &(*functions)[i]; Chunk* chunk = function->chunk;
+
+                function->name = Cache::text(reader);
+                function->parameters = Cache::integer(reader);
+                if(Cache::integer(reader)) function->memo = new Memo();
+
+                uint32_t size = Cache::integer(reader);
+                uint8_t* codes = Cache::bytes(reader, size);
+                if(reader->valid == false) break;
+
+                chunk->codes.assign(codes, codes + size);
+
+                uint32_t runs = Cache::integer(reader);
+
+                for(uint32_t k = 0; k < runs && reader->valid; k++) {
+                    uint32_t length = Cache::integer(reader);
+                    int line = Cache::integer(reader);
+
+                    if(length == 0 || length > size - chunk->lines.size()) reader->valid = false;
+                    else chunk->lines.push(line, length);
+                }
+
+                if(chunk->lines.size() != size) reader->valid = false;
+
+                uint32_t values = Cache::integer(reader);
+
+                for(uint32_t k = 0; k < values && reader->valid; k++) {
+                    Value value;
+                    if(Cache::value(reader, &value, count) == false) break;
+
+                    if(value.index() == VAL_FUNCTION) links.push_back({ chunk, (uint32_t)chunk->values.size(), (uint32_t)value.value.integer });
+                    chunk->values.push_back(value);
+                }
+            }
+
+            for(uint32_t i = 0; i < count && reader->valid; i++)
+                if(Cache::verify(&(*functions)[i]) == false) reader->valid = false;
+
+            if(reader->valid == false) {
+                for(Function& function : *functions) { delete function.memo; delete function.chunk; }
+                functions->clear();
+                return false;
+            }
+
+            for(Link& link : links) link.chunk->values[link.slot] = (*functions)[link.index];
+
+            return true;
+        }
+};
+
+#endif
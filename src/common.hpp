@@ -3,19 +3,26 @@
 
 #include <vector>
 #include <cstdint>
+#include <algorithm>
 #include <map>
+#include <list>
+#include <unordered_map>
 
 #include "types/number.hpp"
 #include "types/boolean.hpp"
 #include "types/string.hpp"
 #include "types/void.hpp"
 
-class Chunk; class Value;
+#define UINT24_MAX 0xffffff
+#define STACK_MAX 1024
+
+class Chunk; class Value; class Memo; class JIT; class Registers; struct Lazy;
 
 struct Function {
     std::string name;
     int parameters = 0;
     Chunk* chunk; 
+    Memo* memo = nullptr;
 };
 
 typedef Value (*Native)(Value* arguments, int parameters);
@@ -26,7 +33,8 @@ typedef enum {
     VAL_STRING,
     VAL_FUNCTION,
     VAL_NATIVE,
-    VAL_VOID
+    VAL_VOID,
+    VAL_INTEGER
 } Values;
 
 class Value {
@@ -40,6 +48,8 @@ class Value {
             Native native;
 
             Void null = Void::VOID();
+
+            int64_t integer;
         } value;
 
         Value() = default;
@@ -53,21 +63,144 @@ class Value {
 
         Value(const Void &nulled) { this->memorized = VAL_VOID; }
 
+        explicit Value(int64_t integer) { this->memorized = VAL_INTEGER; this->value.integer = integer; }
+
         Values index() { return this->memorized; }
 
     private:
         Values memorized = VAL_VOID;
 };
 
+class Memo {
+    public:
+        static size_t CAPACITY;
+        static size_t MEMORY;
+
+        int hits = 0, misses = 0;
+        size_t memory = 0;
+
+        static bool key(Value* arguments, int parameters, std::string* key) {
+            for(int i = 0; i < parameters; i++) {
+                switch(arguments[i].index()) {
+                    case VAL_NUMBER: *key += 'N'; *key += arguments[i].value.number.get(); break;
+                    case VAL_STRING: *key += 'S'; key->append(arguments[i].value.string.data(), arguments[i].value.string.length()); break;
+                    case VAL_BOOLEAN: *key += arguments[i].value.boolean.boolean ? 'T' : 'F'; break;
+                    case VAL_VOID: *key += 'V'; break;
+
+                    default: return false;
+                }
+
+                *key += '\0';
+            }
+
+            return true;
+        }
+
+        bool find(const std::string& key, Value* value) {
+            auto entry = this->index.find(key);
+
+            if(entry == this->index.end()) { this->misses++; return false; }
+
+            this->entries.splice(this->entries.begin(), this->entries, entry->second);
+            *value = entry->second->value;
+
+            this->hits++; return true;
+        }
+
+        void insert(const std::string& key, Value value) {
+            if(this->index.count(key)) return;
+
+            size_t size = Memo::size(key, value);
+            if(size > Memo::MEMORY) return;
+
+            this->entries.push_front({ key, value, size });
+            this->index[key] = this->entries.begin();
+            this->memory += size;
+
+            while(this->entries.size() > Memo::CAPACITY || this->memory > Memo::MEMORY) {
+                Entry* last = &this->entries.back();
+
+                this->memory -= last->size;
+                this->index.erase(last->key);
+                this->entries.pop_back();
+            }
+        }
+
+        template<typename VISITOR>
+        void visit(VISITOR visitor) {
+            for(Entry& entry : this->entries) visitor(entry.value);
+        }
+
+    private:
+        typedef struct {
+            std::string key;
+            Value value;
+            size_t size;
+        } Entry;
+
+        std::list<Entry> entries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+        static size_t size(const std::string& key, Value value) {
+            size_t size = sizeof(Entry) + 2 * key.size();
+
+            if(value.index() == VAL_NUMBER) size += value.value.number.get().size();
+            if(value.index() == VAL_STRING) size += value.value.string.length();
+
+            return size;
+        }
+};
+
+size_t Memo::CAPACITY = 1024;
+size_t Memo::MEMORY = 1 << 20;
+
+class Lines {
+    public:
+        typedef struct {
+            uint32_t offset;
+            int line;
+        } Run;
+
+        std::vector<Run> runs;
+
+        void push(int line, size_t repeat = 1) {
+            if(repeat == 0) return;
+            if(this->runs.empty() || this->runs.back().line != line) this->runs.push_back({ (uint32_t)this->count, line });
+
+            this->count += repeat;
+        }
+
+        int operator[](size_t offset) const {
+            auto run = std::upper_bound(this->runs.begin(), this->runs.end(), offset, [](size_t offset, const Run& run) { return offset < run.offset; });
+            return (run - 1)->line;
+        }
+
+        size_t size() const { return this->count; }
+        size_t length(size_t run) const { return (run + 1 < this->runs.size() ? this->runs[run + 1].offset : this->count) - this->runs[run].offset; }
+
+    private:
+        size_t count = 0;
+};
+
 class Chunk {
     public:
         std::vector<uint8_t> codes;
-        std::vector<int> lines;
+        Lines lines;
         std::vector<Value> values;
 
+        Lazy* lazy = nullptr;
+
+        JIT* jit = nullptr;
+        int calls = 0, edges = 0;
+
+        Native compiled = nullptr;
+
+        Registers* registers = nullptr;
+        int depth = -1;
+
         void write(uint8_t byte, int line) {
             this->codes.push_back(byte);
-            this->lines.push_back(line);
+            this->lines.push(line);
         }
 
         int add(Value value) {
@@ -77,7 +210,7 @@ class Chunk {
 };
 
 enum Operations {
-    OP_CONSTANT,  
+    OP_CONSTANT, OP_CONSTANT_LONG,
     OP_TRUE, OP_FALSE,
     OP_VOID,
     OP_PLUS, OP_MINUS,
@@ -87,14 +220,138 @@ enum Operations {
     OP_EQUALS, OP_NOT_EQUALS,
     OP_GREATER, OP_GREATER_EQUALS, OP_LESS, OP_LESS_EQUALS,
     OP_PRINT, OP_INPUT,
-    OP_DECLARATION, 
-    OP_VARIABLE, OP_LOCAL,
-    OP_ASSIGNMENT_VARIABLE, OP_ASSIGNMENT_LOCAL, 
-    OP_CONDITION, OP_JUMP, OP_LOOP,
-    OP_CALL, OP_RETURN,
+    OP_DECLARATION, OP_DECLARATION_LONG,
+    OP_VARIABLE, OP_VARIABLE_LONG, OP_LOCAL, OP_LOCAL_LONG,
+    OP_ASSIGNMENT_VARIABLE, OP_ASSIGNMENT_VARIABLE_LONG, OP_ASSIGNMENT_LOCAL, OP_ASSIGNMENT_LOCAL_LONG,
+    OP_CONDITION, OP_CONDITION_LONG, OP_JUMP, OP_JUMP_LONG, OP_LOOP, OP_LOOP_LONG,
+    OP_RANGE, OP_RANGE_LONG, OP_RANGE_LOOP, OP_RANGE_LOOP_LONG, OP_COUNTER,
+    OP_CALL, OP_TAIL_CALL, OP_RETURN,
     OP_EMPTY, OP_POP, OP_EXIT
 };
 
+const char* const mnemonics[] = {
+    "CONSTANT", "CONSTANT_LONG",
+    "TRUE", "FALSE",
+    "VOID",
+    "PLUS", "MINUS",
+    "ADD", "SUBTRACT", "MULTIPLY", "DIVIDE", "MOD",
+    "CONCATENATE",
+    "AND", "OR", "NOT",
+    "EQUALS", "NOT_EQUALS",
+    "GREATER", "GREATER_EQUALS", "LESS", "LESS_EQUALS",
+    "PRINT", "INPUT",
+    "DECLARATION", "DECLARATION_LONG",
+    "VARIABLE", "VARIABLE_LONG", "LOCAL", "LOCAL_LONG",
+    "ASSIGNMENT_VARIABLE", "ASSIGNMENT_VARIABLE_LONG", "ASSIGNMENT_LOCAL", "ASSIGNMENT_LOCAL_LONG",
+    "CONDITION", "CONDITION_LONG", "JUMP", "JUMP_LONG", "LOOP", "LOOP_LONG",
+    "RANGE", "RANGE_LONG", "RANGE_LOOP", "RANGE_LOOP_LONG", "COUNTER",
+    "CALL", "TAIL_CALL", "RETURN",
+    "EMPTY", "POP", "EXIT"
+};
+
+int operands(uint8_t instruction) {
+    switch(instruction) {
+        case OP_CONSTANT: case OP_DECLARATION: case OP_VARIABLE: case OP_LOCAL:
+        case OP_ASSIGNMENT_VARIABLE: case OP_ASSIGNMENT_LOCAL:
+        case OP_CALL: case OP_TAIL_CALL: 
+            return 1;
+
+        case OP_LOCAL_LONG: case OP_ASSIGNMENT_LOCAL_LONG: 
+        case OP_CONDITION: case OP_JUMP: case OP_LOOP: 
+        case OP_COUNTER: 
+            return 2;
+
+        case OP_CONSTANT_LONG: case OP_DECLARATION_LONG: case OP_VARIABLE_LONG: case OP_ASSIGNMENT_VARIABLE_LONG: 
+        case OP_CONDITION_LONG: case OP_JUMP_LONG: case OP_LOOP_LONG: 
+            return 3;
+
+        case OP_RANGE: case OP_RANGE_LOOP: return 4;
+        case OP_RANGE_LONG: case OP_RANGE_LOOP_LONG: return 5;
+    }
+
+    return 0;
+}
+
+typedef struct {
+    uint8_t code;
+    int length;
+    uint32_t operand, slot;
+    long target;
+} Instruction;
+
+Instruction decode(std::vector<uint8_t>& codes, size_t i) {
+    Instruction instruction = { codes[i], 1 + operands(codes[i]), 0, 0, -1 };
+
+    int start = 1;
+
+    if(instruction.code == OP_RANGE || instruction.code == OP_RANGE_LONG || instruction.code == OP_RANGE_LOOP || instruction.code == OP_RANGE_LOOP_LONG) {
+        instruction.slot = (codes[i + 1] << 8) | codes[i + 2]; start = 3;
+    }
+
+    for(int k = start; k < instruction.length; k++) instruction.operand = (instruction.operand << 8) | codes[i + k];
+
+    long next = i + instruction.length;
+
+    switch(instruction.code) {
+        case OP_CONDITION: case OP_CONDITION_LONG: case OP_JUMP: case OP_JUMP_LONG:
+        case OP_RANGE: case OP_RANGE_LONG:
+            instruction.target = next + instruction.operand; break;
+
+        case OP_LOOP: case OP_LOOP_LONG: case OP_RANGE_LOOP: case OP_RANGE_LOOP_LONG:
+            instruction.target = next - instruction.operand; break;
+    }
+
+    return instruction;
+}
+
+int effect(Instruction instruction) {
+    switch(instruction.code) {
+        case OP_CONSTANT: case OP_CONSTANT_LONG: case OP_TRUE: case OP_FALSE: case OP_VOID: case OP_INPUT:
+        case OP_VARIABLE: case OP_VARIABLE_LONG: case OP_LOCAL: case OP_LOCAL_LONG: case OP_COUNTER:
+            return 1;
+
+        case OP_ADD: case OP_SUBTRACT: case OP_MULTIPLY: case OP_DIVIDE: case OP_MOD: case OP_CONCATENATE: case OP_AND: case OP_OR:
+        case OP_EQUALS: case OP_NOT_EQUALS: case OP_GREATER: case OP_GREATER_EQUALS: case OP_LESS: case OP_LESS_EQUALS:
+        case OP_PRINT: case OP_DECLARATION: case OP_DECLARATION_LONG: case OP_RETURN: case OP_POP:
+            return -1;
+
+        case OP_CALL: case OP_TAIL_CALL: return -(int)instruction.operand;
+    }
+
+    return 0;
+}
+
+int analyze(Function* function, std::vector<int>* depths, std::vector<bool>* labels) {
+    std::vector<uint8_t>& codes = function->chunk->codes;
+
+    depths->assign(codes.size(), -1); labels->assign(codes.size(), false);
+    std::vector<size_t> work = { 0 };
+
+    (*depths)[0] = function->parameters;
+    int maximum = function->parameters + 1;
+
+    while(work.empty() == false) {
+        size_t i = work.back(); work.pop_back();
+
+        Instruction instruction = decode(codes, i);
+        int depth = (*depths)[i] + effect(instruction);
+
+        if(depth + 1 > maximum) maximum = depth + 1;
+
+        std::vector<long> successors;
+
+        if(instruction.target != -1) { successors.push_back(instruction.target); (*labels)[instruction.target] = true; }
+
+        if(instruction.code != OP_JUMP && instruction.code != OP_JUMP_LONG && instruction.code != OP_LOOP && instruction.code != OP_LOOP_LONG &&
+            instruction.code != OP_RETURN && instruction.code != OP_EXIT) successors.push_back(i + instruction.length);
+
+        for(long successor : successors)
+            if(successor < (long)codes.size() && (*depths)[successor] == -1) { (*depths)[successor] = depth; work.push_back(successor); }
+    }
+
+    return maximum;
+}
+
 typedef enum {
     OPERANDS_ERROR,
     DECLARATION_ERROR,
@@ -103,7 +360,9 @@ typedef enum {
     FUNCTION_ERROR,
     ARGUMENTS_ERROR,
     STACK_OVERFLOW_ERROR,
-    RETURN_ERROR
+    RETURN_ERROR,
+    RANGE_ERROR,
+    PURITY_ERROR
 } RUN_TIME_ERROR;
 
 const std::map<RUN_TIME_ERROR, std::string> run_time_error = {
@@ -114,7 +373,9 @@ const std::map<RUN_TIME_ERROR, std::string> run_time_error = {
     { FUNCTION_ERROR, "The call must invoke a function" },
     { ARGUMENTS_ERROR, "The number of arguments passed does not match with the function ones" },
     { STACK_OVERFLOW_ERROR, "Function stack-overflow" },
-    { RETURN_ERROR, "Can return only from function's bodies" }
+    { RETURN_ERROR, "Can return only from function's bodies" },
+    { RANGE_ERROR, "The bounds of a range must be integer numbers" },
+    { PURITY_ERROR, "Pure functions can call only pure functions" }
 };
 
 typedef enum {
@@ -129,7 +390,10 @@ typedef enum {
     SCOPE_ERROR,
     DEFINE_ERROR,
     EXPECTED_FUNCTION_ERROR,
-    EXPECTED_PARAMETER_ERROR
+    EXPECTED_PARAMETER_ERROR,
+    LOCALS_ERROR,
+    COUNTER_ERROR,
+    IMPURE_ERROR
 } COMPILE_TIME_ERROR;
 
 const std::map<COMPILE_TIME_ERROR, std::string> compile_time_error = {
@@ -144,7 +408,10 @@ const std::map<COMPILE_TIME_ERROR, std::string> compile_time_error = {
     { SCOPE_ERROR, "The identifier is already used" },
     { DEFINE_ERROR, "Functions can be defined only in global scope" },
     { EXPECTED_FUNCTION_ERROR, "Expected a function identifier" },
-    { EXPECTED_PARAMETER_ERROR, "Expected a parameter identifier" }
+    { EXPECTED_PARAMETER_ERROR, "Expected a parameter identifier" },
+    { LOCALS_ERROR, "Too many local variables in one function" },
+    { COUNTER_ERROR, "The counter of a range loop cannot be assigned" },
+    { IMPURE_ERROR, "Pure functions cannot print, read input or use global variables other than to call them" }
 };
 
 #endif
\ No newline at end of file
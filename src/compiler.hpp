@@ -8,6 +8,9 @@
 #include "common.hpp"
 #include "virtual-machine.hpp" 
 #include "tokenizer.hpp"
+#include "statistics.hpp"
+#include "tracer.hpp"
+#include "probes.hpp"
 
 #define GLOBAL_SCOPE 0
 
@@ -18,19 +21,29 @@ class Compiler {
         typedef struct {
             Token local;
             int depth = 0;
+            bool counter = false;
         } Local;
 
-        Local locals[UINT8_MAX + 1];
+        std::vector<Local> locals;
         int count = 0, depths = 0;
 
+        std::map<std::string, int> constants;
+        bool wide = false, overflow = false;
+
         Compiler() { this->function->chunk = new Chunk(); }
 
         ~Compiler() { delete function; }
 
-        void add(Token variable) {
+        bool add(Token variable, bool counter = false) {
+            if(this->count >= STACK_MAX - 1) return false;
+            if((size_t)this->count == this->locals.size()) this->locals.emplace_back();
+
             Local* local = &this->locals[this->count++];
             local->local = variable;                                    
             local->depth = this->depths; 
+            local->counter = counter;
+
+            return true;
         }
 };
 
@@ -98,6 +111,7 @@ Rule rules[TOKEN_NUMBER] = {
 
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, COMMA },      
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, COLON },     
+    { FUNC_NULL,     FUNC_NULL,     PREC_NONE, RANGE },     
 
     { FUNC_GROUPING, FUNC_CALL,     PREC_CALL, OPEN_PARENTHESES },       
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, CLOSE_PARENTHESES },      
@@ -123,19 +137,41 @@ Rule rules[TOKEN_NUMBER] = {
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, ELSE },        
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, WHILE },       
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, FOR },                                         
+    { FUNC_NULL,     FUNC_NULL,     PREC_NONE, IN },                                         
 
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, DEFINE },   
+    { FUNC_NULL,     FUNC_NULL,     PREC_NONE, PURE },   
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, INVOKE },         
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, RETURN },       
 
     { FUNC_NULL,     FUNC_NULL,     PREC_NONE, SEMICOLON },      
 };
 
+struct Lazy {
+    Tokenizer* tokenizer;
+    Tokenizer::State state;
+    Token current, previous;
+};
+
 class Parser {
     public:
-        Function* compile(std::string source) {
-            this->tokenizer = new Tokenizer(source);
-            this->compiler = new Compiler();
+        Function* compile(std::string source) { return this->compile(new Tokenizer(std::move(source))); }
+        Function* compile(const char* source, size_t length) { return this->compile(new Tokenizer(source, length)); }
+
+        Function* compile(Tokenizer* tokenizer) {
+            Allocations::COUNTING = Statistics::ENABLED || Heap::STATISTICS || Allocations::ENABLED;
+            if(Statistics::ENABLED) this->scan(tokenizer);
+
+            auto start = std::chrono::steady_clock::now();
+            if(Tracer::ENABLED) Tracer::begin(Tracer::name("compile"));
+            PROBE1(compile__start, "script");
+
+            bool wide = false;
+            Tokenizer::State initial = tokenizer->save();
+
+            START:
+            this->tokenizer = tokenizer; this->tokenizer->restore(initial);
+            this->compiler = new Compiler(); this->compiler->wide = wide;
             
             this->error = false; this->panic = false;
 
@@ -145,15 +181,57 @@ class Parser {
 
             this->emit_byte(OP_EXIT);
 
+            if(this->compiler->overflow && this->error == false) {
+                this->discard(this->compiler);
+                wide = true; goto START;
+            }
+
+            if(Statistics::ENABLED) Statistics::time(Statistics::COMPILE, start);
+            if(Tracer::ENABLED) Tracer::end();
+            PROBE2(compile__end, "script", this->error == false);
+
             return (this->error) ? NULL : this->compiler->function;
         }
 
+        bool resume(Function* function) {
+            auto start = std::chrono::steady_clock::now();
+            if(Tracer::ENABLED) Tracer::begin(Tracer::name("compile " + function->name));
+            PROBE1(compile__start, function->name.c_str());
+
+            Compiler* enclosing = this->compiler; Tokenizer* tokenizer = this->tokenizer;
+            Token current = this->current, previous = this->previous;
+
+            Lazy* lazy = function->chunk->lazy;
+
+            this->error = false; this->panic = false;
+
+            Function compiled = this->body(lazy, function->memo);
+
+            delete this->compiler;
+            this->compiler = enclosing; this->tokenizer = tokenizer;
+            this->current = current; this->previous = previous;
+
+            if(Statistics::ENABLED) Statistics::time(Statistics::COMPILE, start);
+            if(Tracer::ENABLED) Tracer::end();
+            PROBE2(compile__end, function->name.c_str(), this->error == false);
+
+            if(this->error) return false;
+
+            *(function->chunk) = *(compiled.chunk);
+            delete compiled.chunk; delete lazy;
+
+            return true;
+        }
+
         ~Parser() { delete this->tokenizer; delete this->compiler; }
 
+        static bool LAZY;
+
     private:
         Tokenizer* tokenizer; Compiler* compiler;
         Token current, previous;
         bool error, panic, assignment;
+        size_t tail = SIZE_MAX;
 
         void problem(Token* token, COMPILE_TIME_ERROR error) {
             if(this->panic) return; 
@@ -161,7 +239,7 @@ class Parser {
             std::string message = compile_time_error.find(error)->second;
             this->panic = true; this->error = true;
 
-            if(token->type == ERROR) fprintf(stderr, "[line %d] SYNTAX ERROR in script: %s\n", token->line, token->content.c_str());
+            if(token->type == ERROR) fprintf(stderr, "[line %d] SYNTAX ERROR in script: %.*s\n", token->line, (int)token->content.size(), token->content.data());
             if(token->type != ERROR) fprintf(stderr, "[line %d] COMPILE-TIME ERROR in script: %s\n", token->line, message.c_str());
         }
 
@@ -177,6 +255,16 @@ class Parser {
             }
         }
 
+        void scan(Tokenizer* tokenizer) {
+            auto start = std::chrono::steady_clock::now();
+            Tokenizer::State initial = tokenizer->save();
+
+            for(Token token = tokenizer->next(); token.type != END_OF_FILE && token.type != ERROR; token = tokenizer->next());
+
+            tokenizer->restore(initial);
+            Statistics::time(Statistics::TOKENIZE, start);
+        }
+
         void consume(Types type, COMPILE_TIME_ERROR error = SYNTAX_ERROR) {
             if(this->current.type == type) this->advance();
             else this->problem(&this->current, error);
@@ -190,40 +278,97 @@ class Parser {
 
         bool check(Types type) { return this->current.type == type; }
 
-        uint8_t constant(Value value) {
+        void impure() { if(this->compiler->function->memo != nullptr) this->problem(&this->previous, IMPURE_ERROR); }
+
+        void discard(Compiler* compiler) {
+            Chunk* chunk = compiler->function->chunk;
+
+            for(Value& value : chunk->values)
+                if(value.index() == VAL_FUNCTION) { delete value.value.function.chunk->lazy; delete value.value.function.chunk; delete value.value.function.memo; }
+
+            delete chunk; delete compiler;
+        }
+
+        int constant(Value value) {
+            std::string key;
+
+            if(value.index() == VAL_NUMBER) key = 'N' + value.value.number.get();
+            if(value.index() == VAL_STRING) { key = 'S' + value.value.string.get(); value.value.string.intern(); }
+
+            if(key.empty() == false) {
+                auto found = this->compiler->constants.find(key);
+                if(found != this->compiler->constants.end()) return found->second;
+            }
+
             int constant = this->compiler->function->chunk->add(value);
 
-            if (constant > UINT8_MAX) {                       
+            if (constant > UINT24_MAX) {                       
                 this->problem(&this->previous, CONSTANT_ERROR);      
                 return 0;                                       
             }
 
-            return (uint8_t)constant; 
+            if(key.empty() == false) this->compiler->constants[key] = constant;
+
+            return constant; 
         }
 
-        void emit_byte(uint8_t byte) { this->compiler->function->chunk->write(byte, this->previous.line); } void emit_constant(Value value) { emit_byte(OP_CONSTANT); emit_byte(constant(value)); }
+        void emit_byte(uint8_t byte) { this->compiler->function->chunk->write(byte, this->previous.line); } void emit_constant(Value value) { emit_operand(OP_CONSTANT, constant(value)); }
+
+        void emit_operand(uint8_t instruction, int operand) {
+            if(operand <= UINT8_MAX) { this->emit_byte(instruction); this->emit_byte(operand); return; }
+
+            this->emit_byte(instruction + 1);
+
+            if(instruction != OP_LOCAL && instruction != OP_ASSIGNMENT_LOCAL) this->emit_byte((operand >> 16) & 0xff);
+            this->emit_byte((operand >> 8) & 0xff); this->emit_byte(operand & 0xff);
+        }
 
         int emit_jump(uint8_t instruction) { 
+            if(this->compiler->wide) {
+                this->emit_byte(instruction + 1);
+                this->emit_byte(0xff); this->emit_byte(0xff); this->emit_byte(0xff);
+                return this->compiler->function->chunk->codes.size() - 3;
+            }
+
             this->emit_byte(instruction);
             this->emit_byte(0xff); this->emit_byte(0xff);
             return this->compiler->function->chunk->codes.size() - 2;
         }
 
         void emit_loop(int start) {                    
-            this->emit_byte(OP_LOOP);
+            int offset = this->compiler->function->chunk->codes.size() - start + 3;    
 
-            int offset = this->compiler->function->chunk->codes.size() - start + 2;    
-            if (offset > UINT16_MAX) this->problem(&this->current, LOOP_ERROR);
+            if(offset <= UINT16_MAX) {
+                this->emit_byte(OP_LOOP);
+                this->emit_byte((offset >> 8) & 0xff); this->emit_byte(offset & 0xff);                               
+                return;
+            }
+
+            offset++;
+            if (offset > UINT24_MAX) this->problem(&this->current, LOOP_ERROR);
 
-            this->emit_byte((offset >> 8) & 0xff); this->emit_byte(offset & 0xff);                               
+            this->emit_byte(OP_LOOP_LONG);
+            this->emit_byte((offset >> 16) & 0xff); this->emit_byte((offset >> 8) & 0xff); this->emit_byte(offset & 0xff);
         }   
 
         void patch(int offset) {
-            int jump = this->compiler->function->chunk->codes.size() - offset - 2;
-            if(jump > UINT16_MAX) this->problem(&this->current, JUMP_ERROR);
+            std::vector<uint8_t>* codes = &this->compiler->function->chunk->codes;
+
+            if(this->compiler->wide) {
+                int jump = codes->size() - offset - 3;
+                if(jump > UINT24_MAX) this->problem(&this->current, JUMP_ERROR);
+
+                (*codes)[offset] = (jump >> 16) & 0xff;
+                (*codes)[offset + 1] = (jump >> 8) & 0xff;
+                (*codes)[offset + 2] = jump & 0xff;
+                return;
+            }
+
+            int jump = codes->size() - offset - 2;
+            if(jump > UINT16_MAX) { this->compiler->overflow = true; return; }
 
-            this->compiler->function->chunk->codes[offset] = (jump >> 8) & 0xff;
-            this->compiler->function->chunk->codes[offset + 1] = jump & 0xff;
+            (*codes)[offset] = (jump >> 8) & 0xff;
+            (*codes)[offset + 1] = jump & 0xff;
         }
 
         void precedence(Precedences pre) {
@@ -258,13 +403,13 @@ class Parser {
                 case FUNC_BINARY: this->binary(); break;
                 case FUNC_GROUPING: this->grouping(); break;
 
-                case FUNC_INPUT: this->emit_byte(OP_INPUT); break;
+                case FUNC_INPUT: this->impure(); this->emit_byte(OP_INPUT); break;
 
                 case FUNC_CALL: this->call(); break;
             }
         }
 
-        void number() { Number value(this->previous.content); this->emit_constant(value); } void string() { String value(this->previous.content); this->emit_constant(value); }
+        void number() { Number value(std::string(this->previous.content)); this->emit_constant(value); } void string() { String value(std::string(this->previous.content)); this->emit_constant(value); }
 
         void literal() {
             switch(this->previous.type) {
@@ -276,25 +421,32 @@ class Parser {
  
         void variable() {
             #define ASSIGN(scope, type, variable) do { \
-                    this->emit_byte(scope); this->emit_byte(variable); \
+                    this->emit_operand(scope, variable); \
                     this->expression(); \
                     this->emit_byte(type); \
                     goto ASSIGNMENT; \
                 } while(false)
 
             #define SHORT(scope, type, variable) do { \
-                    this->emit_byte(scope); this->emit_byte(variable); \
-                    Number value("1"); this->emit_constant(value); \
+                    this->emit_operand(scope, variable); \
+                    this->emit_constant(Number::INTEGER(1)); \
                     this->emit_byte(type); \
                     goto ASSIGNMENT; \
                 } while(false)
 
             uint8_t get = 0, set = 0;                                
             int variable = this->local(&this->previous);
+
+            if (variable != GLOBAL_SCOPE - 1 && this->compiler->locals[variable].counter) {
+                if(this->assignment && rules[this->current.type].precedence == PREC_ASSIGNMENT) this->problem(&this->current, COUNTER_ERROR);
+
+                this->emit_byte(OP_COUNTER); this->emit_byte((variable >> 8) & 0xff); this->emit_byte(variable & 0xff);
+                return;
+            }
             
             if (variable != GLOBAL_SCOPE - 1) { get = OP_LOCAL; set = OP_ASSIGNMENT_LOCAL; }
             else {                                             
-                String name(this->previous.content); variable = this->constant(name);                   
+                String name(std::string(this->previous.content)); variable = this->constant(name);                   
                 get = OP_VARIABLE; set = OP_ASSIGNMENT_VARIABLE;                           
             }   
 
@@ -313,9 +465,13 @@ class Parser {
                     if(this->match(DECREMENT)) SHORT(get, OP_SUBTRACT, variable);
 
                     ASSIGNMENT:
-                    this->emit_byte(set); this->emit_byte(variable);
+                    if(set == OP_ASSIGNMENT_VARIABLE) this->impure();
+                    this->emit_operand(set, variable);
+            }
+            else {
+                if(get == OP_VARIABLE && this->check(OPEN_PARENTHESES) == false) this->impure();
+                this->emit_operand(get, variable);
             }
-            else { this->emit_byte(get); this->emit_byte(variable); }
 
             #undef ASSIGN
             #undef SHORT
@@ -383,6 +539,8 @@ class Parser {
 
             this->consume(CLOSE_PARENTHESES, PARAMETER_ERROR); 
             this->emit_byte(OP_CALL); this->emit_byte(arguments);
+
+            this->tail = this->compiler->function->chunk->codes.size();
         }
 
         void expression() { this->precedence(PREC_ASSIGNMENT); }
@@ -410,7 +568,7 @@ class Parser {
         }
 
         void print() {
-            this->consume(PRINT); this->expression();
+            this->consume(PRINT); this->impure(); this->expression();
             this->emit_byte(OP_PRINT);
         }
 
@@ -421,13 +579,13 @@ class Parser {
             this->consume(IDENTIFIER, IDENTIFIER_ERROR);
 
             if(this->compiler->depths == GLOBAL_SCOPE)  {
-                String name(this->previous.content); 
-                uint8_t variable = this->constant(name);
+                String name(std::string(this->previous.content)); 
+                int variable = this->constant(name);
 
                 if(this->match(COLON)) this->expression();                                                    
                 else this->emit_byte(OP_VOID);
 
-                this->emit_byte(OP_DECLARATION); this->emit_byte(variable);
+                this->emit_operand(OP_DECLARATION, variable);
             } 
 
             if(this->compiler->depths != GLOBAL_SCOPE) {
@@ -439,7 +597,7 @@ class Parser {
                     if(token->content == local->local.content) this->problem(&this->current, SCOPE_ERROR);
                 }   
 
-                this->compiler->add(*token);
+                if(this->compiler->add(*token) == false) this->problem(&this->previous, LOCALS_ERROR);
 
                 if(this->match(COLON)) this->expression();                                                    
                 else this->emit_byte(OP_VOID);
@@ -451,16 +609,71 @@ class Parser {
         void definition() {
             if(this->compiler->depths != GLOBAL_SCOPE) { this->problem(&this->current, DEFINE_ERROR); return; }
 
-            this->consume(DEFINE);
-            this->consume(IDENTIFIER, EXPECTED_FUNCTION_ERROR); String name(this->previous.content); 
-            uint8_t function = this->constant(name);
+            this->consume(DEFINE); bool pure = this->match(PURE);
+            this->consume(IDENTIFIER, EXPECTED_FUNCTION_ERROR); String name(std::string(this->previous.content)); 
+            int function = this->constant(name);
 
             Compiler* enclosing = this->compiler; 
 
+            Lazy* lazy = new Lazy({ this->tokenizer, this->tokenizer->save(), this->current, this->previous });
+            Memo* memo = pure ? new Memo() : nullptr;
+
+            Function constant;
+
+            if(Parser::LAZY && this->skip(&constant)) {
+                constant.chunk->lazy = lazy; constant.memo = memo;
+            }
+            else {
+                constant = this->body(lazy, memo);
+                delete lazy;
+            }
+
+            delete this->compiler;
+            this->compiler = enclosing;
+            
+            this->emit_constant(constant);
+            this->emit_operand(OP_DECLARATION, function); 
+        }
+
+        bool skip(Function* function) {
             this->compiler = new Compiler();
             this->compiler->function->name = this->previous.content;
             this->compiler->depths++;
 
+            this->parameter();
+            this->match(END_OF_LINE);
+
+            if(this->check(OPEN_BRACES) == false || this->error) { delete this->compiler->function->chunk; delete this->compiler; return false; }
+
+            int depth = 0;
+
+            do {
+                if(this->check(OPEN_BRACES)) depth++;
+                if(this->check(CLOSE_BRACES)) depth--;
+
+                this->advance();
+            } while(depth > 0 && this->check(END_OF_FILE) == false && this->error == false);
+
+            if(depth > 0) this->problem(&this->current, BLOCK_ERROR);
+            if(this->match(SEMICOLON) == false) this->match(END_OF_LINE);
+
+            *function = *(this->compiler->function);
+
+            return true;
+        }
+
+        Function body(Lazy* lazy, Memo* memo) {
+            bool wide = false;
+
+            BODY:
+            this->tokenizer = lazy->tokenizer; this->tokenizer->restore(lazy->state);
+            this->current = lazy->current; this->previous = lazy->previous;
+
+            this->compiler = new Compiler(); this->compiler->wide = wide;
+            this->compiler->function->name = this->previous.content;
+            this->compiler->function->memo = memo;
+            this->compiler->depths++;
+
             this->parameter();
             
             this->match(END_OF_LINE);
@@ -469,12 +682,12 @@ class Parser {
 
             this->emit_byte(OP_VOID); this->emit_byte(OP_RETURN);
 
-            Function constant = *(this->compiler->function);
+            if(this->compiler->overflow && this->error == false) {
+                this->discard(this->compiler);
+                wide = true; goto BODY;
+            }
 
-            this->compiler = enclosing;
-            
-            this->emit_constant(constant);
-            this->emit_byte(OP_DECLARATION); this->emit_byte(function); 
+            return *(this->compiler->function);
         }
 
         void parameter() {
@@ -494,7 +707,7 @@ class Parser {
                         if(token->content == local->local.content) this->problem(&this->current, SCOPE_ERROR);
                     }   
 
-                    this->compiler->add(*token);
+                    if(this->compiler->add(*token) == false) this->problem(&this->previous, LOCALS_ERROR);
 
                     if(this->match(COMMA)) goto PARAMETER;
                     this->consume(CLOSE_PARENTHESES, SYNTAX_ERROR);
@@ -506,9 +719,14 @@ class Parser {
         void returning() {
             this->consume(RETURN);
 
+            this->tail = SIZE_MAX;
+
             if(this->check(SEMICOLON) || this->check(END_OF_LINE)) this->emit_byte(OP_VOID);
             else this->expression();
 
+            std::vector<uint8_t>* codes = &this->compiler->function->chunk->codes;
+            if(this->tail == codes->size()) (*codes)[codes->size() - 2] = OP_TAIL_CALL;
+
             this->emit_byte(OP_RETURN);
         }
 
@@ -568,9 +786,11 @@ class Parser {
         }
 
         void counter() {
+            this->consume(FOR); 
+            if(this->check(IDENTIFIER)) { this->range(); return; }
+
             this->compiler->depths++;
 
-            this->consume(FOR); 
             this->consume(OPEN_PARENTHESES, SYNTAX_ERROR);
 
             switch(this->current.type) {
@@ -623,6 +843,55 @@ class Parser {
                 this->compiler->count--;                               
             }
         }
+
+        void range() {
+            this->compiler->depths++;
+
+            this->consume(IDENTIFIER, IDENTIFIER_ERROR); Token variable = this->previous;
+            this->consume(IN, SYNTAX_ERROR);
+
+            this->expression(); this->consume(RANGE, SYNTAX_ERROR); this->expression();
+            this->consume(COLON, SYNTAX_ERROR); this->match(END_OF_LINE);
+
+            int slot = this->compiler->count;
+            Token limit = variable; limit.content = "";
+
+            if(this->compiler->add(variable, true) == false || this->compiler->add(limit) == false) this->problem(&this->previous, LOCALS_ERROR);
+
+            this->emit_byte(this->compiler->wide ? OP_RANGE_LONG : OP_RANGE);
+            this->emit_byte((slot >> 8) & 0xff); this->emit_byte(slot & 0xff);
+
+            this->emit_byte(0xff); this->emit_byte(0xff);
+            if(this->compiler->wide) this->emit_byte(0xff);
+
+            int exit = this->compiler->function->chunk->codes.size() - (this->compiler->wide ? 3 : 2);
+            int body = this->compiler->function->chunk->codes.size();
+
+            this->statement();
+
+            int offset = this->compiler->function->chunk->codes.size() - body + 5;
+
+            if(offset > UINT16_MAX) offset++;
+            if(offset > UINT24_MAX) this->problem(&this->current, LOOP_ERROR);
+
+            this->emit_byte(offset > UINT16_MAX ? OP_RANGE_LOOP_LONG : OP_RANGE_LOOP);
+            this->emit_byte((slot >> 8) & 0xff); this->emit_byte(slot & 0xff);
+
+            if(offset > UINT16_MAX) this->emit_byte((offset >> 16) & 0xff);
+            this->emit_byte((offset >> 8) & 0xff); this->emit_byte(offset & 0xff);
+
+            this->patch(exit);
+
+            this->compiler->depths--;
+
+            while(this->compiler->count > 0 && 
+                   this->compiler->locals[this->compiler->count - 1].depth > this->compiler->depths) {                       
+                this->emit_byte(OP_POP);                                    
+                this->compiler->count--;                               
+            }
+        }
 };
 
+bool Parser::LAZY = false;
+
 #endif
\ No newline at end of file
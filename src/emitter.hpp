@@ -0,0 +1,193 @@
+#ifndef EMITTER_H
+#define EMITTER_H
+
+#include <string>
+#include <vector>
+#include <map>
+
+#include "common.hpp"
+
+class Emitter {
+    public:
+        std::string emit(Function* script) {
+            this->collect(script);
+
+            this->output = "#include \"runtime.hpp\"\n\n";
+
+            for(size_t i = 0; i < this->functions.size(); i++)
+                this->output += "Chunk c" + std::to_string(i) + "; Value f" + std::to_string(i) + "(Value* arguments, int parameters);\n";
+
+            for(size_t i = 0; i < this->functions.size(); i++) this->constants(i);
+            for(size_t i = 0; i < this->functions.size(); i++) this->function(i);
+
+            this->output += "int main() {\n    Runtime::initialize();\n\n";
+
+            for(size_t i = 0; i < this->functions.size(); i++)
+                this->output += "    c" + std::to_string(i) + ".compiled = f" + std::to_string(i) + ";\n";
+
+            this->output += "\n    f0(nullptr, 0);\n}\n";
+
+            return this->output;
+        }
+
+    private:
+        std::vector<Function*> functions;
+        std::map<Chunk*, int> indexes;
+        std::string output;
+
+        void collect(Function* function) {
+            this->indexes[function->chunk] = this->functions.size();
+            this->functions.push_back(function);
+
+            for(Value& value : function->chunk->values)
+                if(value.index() == VAL_FUNCTION && this->indexes.count(value.value.function.chunk) == 0) this->collect(&value.value.function);
+        }
+
+        static std::string literal(std::string string) {
+            std::string result = "\"";
+
+            for(unsigned char character : string) {
+                if(character == '"' || character == '\\') { result += '\\'; result += character; }
+                else if(character < 0x20 || character >= 0x7f) { char escape[8]; snprintf(escape, sizeof(escape), "\\%03o", character); result += escape; }
+                else result += character;
+            }
+
+            return result + "\"";
+        }
+
+        void constants(int index) {
+            Chunk* chunk = this->functions[index]->chunk;
+            if(chunk->values.empty()) return;
+
+            this->output += "Value k" + std::to_string(index) + "[] = {\n";
+
+            for(Value& value : chunk->values) {
+                switch(value.index()) {
+                    case VAL_NUMBER: this->output += "    Value(Number(" + Emitter::literal(value.value.number.get()) + ")),\n"; break;
+                    case VAL_STRING: this->output += "    Value(String(" + Emitter::literal(value.value.string.get()) + ")),\n"; break;
+
+                    case VAL_FUNCTION: {
+                        Function* function = &value.value.function;
+
+                        this->output += "    Value(Function{ " + Emitter::literal(function->name) + ", " + std::to_string(function->parameters) + ", &c" + std::to_string(this->indexes[function->chunk]);
+                        this->output += function->memo != nullptr ? ", new Memo() }),\n" : ", nullptr }),\n";
+                        break;
+                    }
+
+                    default: this->output += "    Value(Void::VOID()),\n"; break;
+                }
+            }
+
+            this->output += "};\n";
+        }
+
+        void function(int index) {
+            Function* function = this->functions[index];
+            std::vector<uint8_t>& codes = function->chunk->codes;
+            Lines& lines = function->chunk->lines;
+
+            std::vector<int> depths; std::vector<bool> labels;
+            int maximum = analyze(function, &depths, &labels);
+
+            std::string k = "k" + std::to_string(index);
+            auto S = [](long slot) { return "s[" + std::to_string(slot) + "]"; };
+
+            this->output += "\n/* " + (function->name.empty() ? std::string("script") : function->name) + " */\n";
+            this->output += "Value f" + std::to_string(index) + "(Value* arguments, int parameters) {\n";
+            this->output += "    Value s[" + std::to_string(maximum) + "];\n";
+            this->output += "    for(int i = 0; i < parameters; i++) s[i] = arguments[i];\n\n";
+            this->output += "    START:\n";
+
+            for(size_t i = 0; i < codes.size(); i += 1 + operands(codes[i])) {
+                if(depths[i] == -1) continue;
+
+                Instruction instruction = decode(codes, i);
+                int d = depths[i]; std::string line = std::to_string(lines[i]);
+
+                std::string target = "L" + std::to_string(instruction.target);
+                std::string identifier = instruction.code == OP_DECLARATION || instruction.code == OP_DECLARATION_LONG || instruction.code == OP_VARIABLE || instruction.code == OP_VARIABLE_LONG ||
+                    instruction.code == OP_ASSIGNMENT_VARIABLE || instruction.code == OP_ASSIGNMENT_VARIABLE_LONG ? Emitter::literal(function->chunk->values[instruction.operand].value.string.get()) : "";
+
+                if(labels[i]) this->output += "    L" + std::to_string(i) + ":\n";
+
+                this->output += "    ";
+
+                if((instruction.code == OP_CALL || instruction.code == OP_TAIL_CALL) && function->memo != nullptr)
+                    this->output += "Runtime::purity(&" + S(d - instruction.operand - 1) + ", " + line + ");\n    ";
+
+                switch(instruction.code) {
+                    case OP_CONSTANT: case OP_CONSTANT_LONG: this->output += S(d) + " = " + k + "[" + std::to_string(instruction.operand) + "];"; break;
+
+                    case OP_TRUE: this->output += S(d) + " = Boolean::TRUE();"; break;
+                    case OP_FALSE: this->output += S(d) + " = Boolean::FALSE();"; break;
+                    case OP_VOID: this->output += S(d) + " = Void::VOID();"; break;
+
+                    case OP_PLUS: this->output += "Runtime::plus(&" + S(d - 1) + ", " + line + ");"; break;
+                    case OP_MINUS: this->output += "Runtime::minus(&" + S(d - 1) + ", " + line + ");"; break;
+                    case OP_NOT: this->output += "Runtime::negation(&" + S(d - 1) + ", " + line + ");"; break;
+
+                    case OP_ADD: this->output += "Runtime::binary<OP_ADD>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_SUBTRACT: this->output += "Runtime::binary<OP_SUBTRACT>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_MULTIPLY: this->output += "Runtime::binary<OP_MULTIPLY>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_DIVIDE: this->output += "Runtime::binary<OP_DIVIDE>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_MOD: this->output += "Runtime::binary<OP_MOD>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_CONCATENATE: this->output += "Runtime::binary<OP_CONCATENATE>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_AND: this->output += "Runtime::binary<OP_AND>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_OR: this->output += "Runtime::binary<OP_OR>(&" + S(d - 2) + ", " + line + ");"; break;
+
+                    case OP_EQUALS: this->output += "Runtime::comparison<OP_EQUALS>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_NOT_EQUALS: this->output += "Runtime::comparison<OP_NOT_EQUALS>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_GREATER: this->output += "Runtime::comparison<OP_GREATER>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_GREATER_EQUALS: this->output += "Runtime::comparison<OP_GREATER_EQUALS>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_LESS: this->output += "Runtime::comparison<OP_LESS>(&" + S(d - 2) + ", " + line + ");"; break;
+                    case OP_LESS_EQUALS: this->output += "Runtime::comparison<OP_LESS_EQUALS>(&" + S(d - 2) + ", " + line + ");"; break;
+
+                    case OP_PRINT: this->output += "Runtime::print(&" + S(d - 1) + ");"; break;
+                    case OP_INPUT: this->output += "Runtime::input(&" + S(d) + ");"; break;
+
+                    case OP_DECLARATION: case OP_DECLARATION_LONG: this->output += "Runtime::declaration(" + identifier + ", &" + S(d - 1) + ", " + line + ");"; break;
+                    case OP_VARIABLE: case OP_VARIABLE_LONG: this->output += S(d) + " = Runtime::globals.get(" + identifier + ");"; break;
+                    case OP_ASSIGNMENT_VARIABLE: case OP_ASSIGNMENT_VARIABLE_LONG: this->output += "Runtime::assignment(" + identifier + ", &" + S(d - 1) + ", " + line + ");"; break;
+
+                    case OP_LOCAL: case OP_LOCAL_LONG: this->output += S(d) + " = " + S(instruction.operand) + ";"; break;
+                    case OP_ASSIGNMENT_LOCAL: case OP_ASSIGNMENT_LOCAL_LONG: this->output += S(instruction.operand) + " = " + S(d - 1) + ";"; break;
+
+                    case OP_CONDITION: case OP_CONDITION_LONG: this->output += "if(Runtime::condition(&" + S(d - 1) + ", " + line + ") == false) goto " + target + ";"; break;
+                    case OP_JUMP: case OP_JUMP_LONG: case OP_LOOP: case OP_LOOP_LONG: this->output += "goto " + target + ";"; break;
+
+                    case OP_RANGE: case OP_RANGE_LONG: this->output += "if(Runtime::range(&" + S(instruction.slot) + ", " + line + ") == false) goto " + target + ";"; break;
+                    case OP_RANGE_LOOP: case OP_RANGE_LOOP_LONG:
+                        this->output += "if(++" + S(instruction.slot) + ".value.integer < " + S(instruction.slot + 1) + ".value.integer) goto " + target + ";"; break;
+                    case OP_COUNTER: this->output += S(d) + " = Number::INTEGER(" + S(instruction.operand) + ".value.integer);"; break;
+
+                    case OP_TAIL_CALL: {
+                        int n = instruction.operand; long callee = d - n - 1;
+
+                        this->output += "if(Runtime::self(&" + S(callee) + ", &c" + std::to_string(index) + ", " + std::to_string(n) + ")) { ";
+                        for(int a = 0; a < n; a++) this->output += S(a) + " = " + S(callee + 1 + a) + "; ";
+                        this->output += "goto START; }\n    ";
+
+                        if(index != 0 && function->memo == nullptr)
+                            this->output += "if(Runtime::tail(&" + S(callee) + ", " + std::to_string(n) + ", " + line + ")) return Void::VOID();\n    ";
+                    }
+                    [[fallthrough]];
+                    case OP_CALL: this->output += "Runtime::call(&" + S(d - instruction.operand - 1) + ", " + std::to_string(instruction.operand) + ", " + line + ");"; break;
+
+                    case OP_RETURN:
+                        if(index == 0) this->output += "Runtime::error(RETURN_ERROR, " + line + ");";
+                        else this->output += "return " + S(d - 1) + ";";
+                        break;
+
+                    case OP_EXIT: this->output += "return Void::VOID();"; break;
+
+                    default: this->output += ";"; break;
+                }
+
+                this->output += "\n";
+            }
+
+            this->output += "\n    return Void::VOID();\n}\n";
+        }
+};
+
+#endif
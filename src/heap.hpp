@@ -0,0 +1,164 @@
+#ifndef HEAP_H
+#define HEAP_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+#include "allocations.hpp"
+
+#define HEAP_GRANULE 16
+#define HEAP_CLASSES 16
+#define HEAP_OUTSIDE 255
+
+class Heap {
+    public:
+        static size_t THRESHOLD;
+        static double GROWTH;
+        static bool STATISTICS;
+        static uint8_t OPCODE;
+        static Heap* current;
+
+        Heap() = default;
+        Heap(const Heap&) = delete;
+        Heap& operator=(const Heap&) = delete;
+
+        ~Heap() {
+            if(Heap::current == this) Heap::current = &Heap::global;
+
+            while(this->objects != nullptr) { Object* object = this->objects; this->objects = object->next; free(object); }
+            this->release();
+
+            Heap::retired.collections += this->collections; Heap::retired.allocated += this->allocated; Heap::retired.freed += this->freed;
+            Heap::retired.bytes += this->bytes; Heap::retired.reused += this->reused; Heap::retired.paused += this->paused;
+            Heap::retired.peak = std::max(Heap::retired.peak, this->peak); Heap::retired.longest = std::max(Heap::retired.longest, this->longest);
+
+            for(int i = 0; i < 256; i++) Heap::retired.operations[i] += this->operations[i];
+        }
+
+        char* allocate(size_t size) {
+            size_t kind = (size + HEAP_GRANULE - 1) / HEAP_GRANULE - 1;
+            Object* object;
+
+            if(kind < HEAP_CLASSES && this->pools[kind] != nullptr) {
+                object = this->pools[kind]; this->pools[kind] = object->next;
+                this->pooled -= (kind + 1) * HEAP_GRANULE; this->reused++;
+            }
+            else object = (Object*)malloc(sizeof(Object) + (kind < HEAP_CLASSES ? (kind + 1) * HEAP_GRANULE : size));
+
+            object->next = this->objects; object->size = size; object->marked = false; object->site = 0;
+            this->objects = object;
+
+            this->bytes += size; this->allocated += size;
+            if(this->bytes > this->peak) this->peak = this->bytes;
+
+            if(Allocations::COUNTING) { this->operations[Heap::OPCODE]++; if(Allocations::ENABLED) object->site = Allocations::allocate(Allocations::STRING, size); }
+
+            return (char*)(object + 1);
+        }
+
+        static size_t allocations() {
+            size_t total = 0;
+            for(int i = 0; i < 256; i++) total += Heap::retired.operations[i] + Heap::current->operations[i];
+
+            return total;
+        }
+
+        static size_t volume() { return Heap::retired.allocated + Heap::current->allocated; }
+
+        bool pending() { return this->bytes >= Heap::THRESHOLD && this->bytes >= this->next; }
+
+        static void mark(const char* data) { ((Object*)data - 1)->marked = true; }
+        static bool marked(const char* data) { return ((Object*)data - 1)->marked; }
+
+        void sweep(std::chrono::steady_clock::time_point start) {
+            Object** link = &this->objects;
+
+            while(*link != nullptr) {
+                Object* object = *link;
+
+                if(object->marked) { object->marked = false; link = &object->next; continue; }
+
+                *link = object->next;
+
+                this->bytes -= object->size; this->freed += object->size;
+                if(object->site != 0) Allocations::release(object->site, object->size);
+                this->recycle(object);
+            }
+
+            this->next = this->bytes * Heap::GROWTH;
+
+            double pause = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            this->collections++; this->paused += pause;
+            if(pause > this->longest) this->longest = pause;
+        }
+
+        void release() {
+            for(Object*& pool : this->pools)
+                while(pool != nullptr) { Object* object = pool; pool = object->next; free(object); }
+
+            this->pooled = 0;
+        }
+
+        static void report(const char* const names[], int count) {
+            Heap* heap = Heap::current;
+            size_t operations[256];
+
+            for(int i = 0; i < 256; i++) operations[i] = Heap::retired.operations[i] + heap->operations[i];
+
+            fprintf(stderr, "[gc] %zu collections, %zu bytes allocated, %zu freed, %zu live, pauses %.3f ms total / %.3f ms max\n",
+                Heap::retired.collections + heap->collections, Heap::retired.allocated + heap->allocated, Heap::retired.freed + heap->freed,
+                Heap::retired.bytes + heap->bytes, Heap::retired.paused + heap->paused, std::max(Heap::retired.longest, heap->longest));
+            fprintf(stderr, "[heap] %zu bytes in use, %zu high water, %zu pooled, %zu blocks reused\n",
+                Heap::retired.bytes + heap->bytes, std::max(Heap::retired.peak, heap->peak), heap->pooled, Heap::retired.reused + heap->reused);
+
+            for(int i = 0; i < 256; i++)
+                if(operations[i] > 0) fprintf(stderr, "[heap] %-26s %zu allocations\n", i < count ? names[i] : "(outside the interpreter)", operations[i]);
+        }
+
+    private:
+        typedef struct Object {
+            struct Object* next;
+            size_t size;
+            bool marked;
+            uint32_t site;
+        } Object;
+
+        typedef struct {
+            size_t bytes, allocated, freed, collections, peak, reused;
+            size_t operations[256];
+            double paused, longest;
+        } Retired;
+
+        static Heap global;
+        static Retired retired;
+
+        Object* objects = nullptr;
+        Object* pools[HEAP_CLASSES] = {};
+        size_t bytes = 0, next = 0, allocated = 0, freed = 0, collections = 0, peak = 0, pooled = 0, reused = 0;
+        size_t operations[256] = {};
+        double paused = 0, longest = 0;
+
+        void recycle(Object* object) {
+            size_t kind = (object->size + HEAP_GRANULE - 1) / HEAP_GRANULE - 1;
+
+            if(kind >= HEAP_CLASSES) { free(object); return; }
+
+            object->next = this->pools[kind]; this->pools[kind] = object;
+            this->pooled += (kind + 1) * HEAP_GRANULE;
+        }
+};
+
+size_t Heap::THRESHOLD = 1 << 20;
+double Heap::GROWTH = 2;
+bool Heap::STATISTICS = false;
+uint8_t Heap::OPCODE = HEAP_OUTSIDE;
+
+Heap Heap::global;
+Heap* Heap::current = &Heap::global;
+Heap::Retired Heap::retired = {};
+
+#endif
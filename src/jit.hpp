@@ -0,0 +1,183 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include "common.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define JIT_SUPPORTED
+#endif
+
+class VM;
+
+class JIT {
+    public:
+        static bool ENABLED;
+        static int CALLS, EDGES;
+
+        typedef int (*Helper)(VM* vm, uint32_t operand);
+        typedef uint32_t (*Trampoline)(VM* vm, uint8_t* target);
+
+        ~JIT() {
+            #ifdef JIT_SUPPORTED
+            munmap(this->memory, this->size);
+            #endif
+        }
+
+        static JIT* compile(std::vector<uint8_t>* codes, std::string name, Helper helpers[]) {
+            #ifdef JIT_SUPPORTED
+            JIT* jit = new JIT();
+            jit->base = codes->data();
+
+            jit->prologue();
+
+            std::vector<int> entries(codes->size(), -1);
+
+            for(size_t i = 0; i < codes->size(); i += 1 + operands((*codes)[i])) {
+                Instruction instruction = decode(*codes, i);
+
+                entries[i] = jit->buffer.size();
+
+                switch(instruction.code) {
+                    case OP_JUMP: case OP_JUMP_LONG: case OP_LOOP: case OP_LOOP_LONG:
+                        jit->jump(0xe9, instruction.target);
+                        break;
+
+                    case OP_CONDITION: case OP_CONDITION_LONG: {
+                        jit->call(helpers[instruction.code], 0);
+
+                        jit->emit({ 0x83, 0xf8, 0x01, 0x74, 0x12, 0x85, 0xc0 });
+                        jit->jump(0x0f, instruction.target, 0x84);
+                        jit->exit(i);
+                        break;
+                    }
+
+                    case OP_RANGE_LOOP: case OP_RANGE_LOOP_LONG: {
+                        jit->call(helpers[instruction.code], instruction.slot);
+
+                        jit->emit({ 0x85, 0xc0 });
+                        jit->jump(0x0f, instruction.target, 0x85);
+                        break;
+                    }
+
+                    default:
+                        if(helpers[instruction.code] == nullptr) { jit->exit(i); break; }
+
+                        jit->call(helpers[instruction.code], instruction.operand);
+
+                        jit->emit({ 0x85, 0xc0, 0x74, 0x0a });
+                        jit->exit(i);
+                        break;
+                }
+            }
+
+            for(auto fixup : jit->fixups) {
+                if(fixup.second >= (int)entries.size() || entries[fixup.second] == -1) { delete jit; return nullptr; }
+
+                int32_t relative = entries[fixup.second] - (fixup.first + 4);
+                memcpy(&jit->buffer[fixup.first], &relative, 4);
+            }
+
+            long page = sysconf(_SC_PAGESIZE);
+            jit->size = (jit->buffer.size() + page - 1) / page * page;
+
+            void* memory = mmap(nullptr, jit->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(memory == MAP_FAILED) { jit->size = 0; delete jit; return nullptr; }
+
+            jit->memory = (uint8_t*)memory;
+            memcpy(jit->memory, jit->buffer.data(), jit->buffer.size());
+
+            if(mprotect(jit->memory, jit->size, PROT_READ | PROT_EXEC) != 0) { delete jit; return nullptr; }
+
+            jit->entries.resize(entries.size());
+            for(size_t i = 0; i < entries.size(); i++) jit->entries[i] = entries[i] == -1 ? nullptr : jit->memory + entries[i];
+
+            JIT::perf(jit->memory, jit->buffer.size(), name.empty() ? "script" : name);
+
+            jit->buffer.clear(); jit->buffer.shrink_to_fit();
+            jit->fixups.clear(); jit->fixups.shrink_to_fit();
+
+            return jit;
+            #else
+            return nullptr;
+            #endif
+        }
+
+        uint8_t* enter(VM* vm, uint8_t* pc) {
+            uint8_t* target = this->entries[pc - this->base];
+            if(target == nullptr) return pc;
+
+            return this->base + ((Trampoline)this->memory)(vm, target);
+        }
+
+    private:
+        uint8_t* memory = nullptr; size_t size = 0;
+        uint8_t* base;
+
+        std::vector<uint8_t*> entries;
+
+        std::vector<uint8_t> buffer;
+        std::vector<std::pair<int, int>> fixups;
+        int epilogue = 0;
+
+        void emit(std::initializer_list<uint8_t> bytes) { this->buffer.insert(this->buffer.end(), bytes); }
+
+        void emit32(uint32_t value) { for(int i = 0; i < 4; i++) this->buffer.push_back((value >> (i * 8)) & 0xff); }
+
+        void prologue() {
+            this->emit({ 0x53, 0x48, 0x89, 0xfb, 0xff, 0xe6 });
+
+            this->epilogue = this->buffer.size();
+            this->emit({ 0x5b, 0xc3 });
+        }
+
+        void call(Helper helper, uint32_t operand) {
+            this->emit({ 0x48, 0x89, 0xdf });
+            this->emit({ 0xbe }); this->emit32(operand);
+
+            this->emit({ 0x48, 0xb8 });
+            uint64_t address = (uint64_t)helper;
+            for(int i = 0; i < 8; i++) this->buffer.push_back((address >> (i * 8)) & 0xff);
+
+            this->emit({ 0xff, 0xd0 });
+        }
+
+        void exit(uint32_t offset) {
+            this->emit({ 0xb8 }); this->emit32(offset);
+
+            this->emit({ 0xe9 });
+            this->emit32(this->epilogue - (this->buffer.size() + 4));
+        }
+
+        void jump(uint8_t opcode, int target, int condition = -1) {
+            this->buffer.push_back(opcode);
+            if(condition != -1) this->buffer.push_back(condition);
+
+            this->fixups.push_back({ (int)this->buffer.size(), target });
+            this->emit32(0);
+        }
+
+        static void perf(uint8_t* start, size_t size, std::string name) {
+            #ifdef JIT_SUPPORTED
+            std::string path = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+
+            FILE* map = fopen(path.c_str(), "a");
+            if(map == nullptr) return;
+
+            fprintf(map, "%lx %lx magnum::%s\n", (unsigned long)start, (unsigned long)size, name.c_str());
+            fclose(map);
+            #endif
+        }
+};
+
+bool JIT::ENABLED = false;
+int JIT::CALLS = 1000, JIT::EDGES = 10000;
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PROBES_SUPPORTED
+#endif
+#endif
+
+#ifdef PROBES_SUPPORTED
+#define PROBE0(name) DTRACE_PROBE(magnum, name)
+#define PROBE1(name, a) DTRACE_PROBE1(magnum, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(magnum, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(magnum, name, a, b, c)
+#else
+#define PROBE0(name) do {} while(false)
+#define PROBE1(name, a) do {} while(false)
+#define PROBE2(name, a, b) do {} while(false)
+#define PROBE3(name, a, b, c) do {} while(false)
+#endif
+
+#endif
@@ -0,0 +1,160 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "registers.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <signal.h>
+#include <sys/time.h>
+#define PROFILER_SUPPORTED
+#endif
+
+#define PROFILER_SITES (1 << 20)
+#define PROFILER_HOTTEST 20
+
+class Profiler {
+    public:
+        static bool ENABLED;
+        static int INTERVAL;
+
+        typedef struct {
+            Chunk* chunk;
+            uintptr_t address;
+        } Site;
+
+        static bool start(void (*handler)(int)) {
+            #ifdef PROFILER_SUPPORTED
+            if(Profiler::sites == nullptr) Profiler::sites = new Site[PROFILER_SITES];
+
+            struct sigaction action = {};
+            action.sa_handler = handler; action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+
+            if(sigaction(SIGPROF, &action, nullptr) != 0) return false;
+
+            struct itimerval timer = {};
+            timer.it_interval.tv_sec = timer.it_value.tv_sec = Profiler::INTERVAL / 1000000;
+            timer.it_interval.tv_usec = timer.it_value.tv_usec = Profiler::INTERVAL % 1000000;
+
+            return setitimer(ITIMER_PROF, &timer, nullptr) == 0;
+            #else
+            return false;
+            #endif
+        }
+
+        static void stop() {
+            #ifdef PROFILER_SUPPORTED
+            struct itimerval timer = {};
+            setitimer(ITIMER_PROF, &timer, nullptr);
+            #endif
+        }
+
+        static Site* reserve(int depth) {
+            if(Profiler::used + depth + 1 > PROFILER_SITES) { Profiler::dropped++; return nullptr; }
+
+            Site* sample = &Profiler::sites[Profiler::used];
+            sample->chunk = nullptr; sample->address = depth;
+
+            Profiler::used += depth + 1;
+
+            return sample + 1;
+        }
+
+        static void resolve(const std::unordered_map<Chunk*, std::string>& names) {
+            for(size_t i = 0; i < Profiler::used; i += Profiler::sites[i].address + 1) {
+                std::string stack; std::set<std::pair<std::string, int>> seen;
+
+                for(size_t k = 1; k <= Profiler::sites[i].address; k++) {
+                    Site* site = &Profiler::sites[i + k];
+                    auto name = names.find(site->chunk);
+
+                    std::pair<std::string, int> line = { name == names.end() ? "?" : name->second, name == names.end() ? 0 : Profiler::line(site) };
+
+                    stack += (k > 1 ? ";" : "") + line.first + ":" + std::to_string(line.second);
+
+                    if(seen.insert(line).second) Profiler::lines[line].total++;
+                    if(k == Profiler::sites[i].address) Profiler::lines[line].self++;
+                }
+
+                Profiler::stacks[stack]++; Profiler::samples++;
+            }
+
+            Profiler::used = 0;
+        }
+
+        static void report(std::string path) {
+            if(path.empty() == false) {
+                FILE* file = fopen(path.c_str(), "w");
+
+                if(file == nullptr) fprintf(stderr, "Cannot write the profile `%s`\n", path.c_str());
+                else {
+                    for(auto& entry : Profiler::stacks) fprintf(file, "%s %zu\n", entry.first.c_str(), entry.second);
+                    fclose(file);
+                }
+            }
+
+            #ifndef PROFILER_SUPPORTED
+            fprintf(stderr, "[profile] sampling is not supported on this platform\n");
+            #endif
+
+            fprintf(stderr, "[profile] %zu samples every %d us, %zu dropped\n", Profiler::samples, Profiler::INTERVAL, Profiler::dropped);
+            if(Profiler::samples == 0) return;
+
+            std::vector<std::pair<std::pair<std::string, int>, Count>> hottest(Profiler::lines.begin(), Profiler::lines.end());
+            std::sort(hottest.begin(), hottest.end(), [](auto& left, auto& right) { return left.second.self > right.second.self || (left.second.self == right.second.self && left.second.total > right.second.total); });
+
+            fprintf(stderr, "[profile] %7s %7s %7s  %s\n", "self", "total", "line", "function");
+
+            for(size_t i = 0; i < hottest.size() && i < PROFILER_HOTTEST; i++)
+                fprintf(stderr, "[profile] %6.1f%% %6.1f%% %7d  %s\n", 100.0 * hottest[i].second.self / Profiler::samples,
+                    100.0 * hottest[i].second.total / Profiler::samples, hottest[i].first.second, hottest[i].first.first.c_str());
+        }
+
+    private:
+        typedef struct {
+            size_t self, total;
+        } Count;
+
+        static Site* sites;
+        static volatile size_t used;
+        static size_t dropped, samples;
+
+        static std::map<std::string, size_t> stacks;
+        static std::map<std::pair<std::string, int>, Count> lines;
+
+        static int line(Site* site) {
+            Chunk* chunk = site->chunk;
+
+            if(Registers::ENABLED) {
+                if(chunk->registers == nullptr) return 0;
+
+                uintptr_t start = (uintptr_t)chunk->registers->codes.data(), offset = (site->address - start) / sizeof(Registers::Instruction);
+                return site->address >= start && offset <= chunk->registers->codes.size() ? chunk->registers->lines[offset == 0 ? 0 : offset - 1] : 0;
+            }
+
+            uintptr_t start = (uintptr_t)chunk->codes.data(), offset = site->address - start;
+            return site->address >= start && offset <= chunk->codes.size() ? chunk->lines[offset == 0 ? 0 : offset - 1] : 0;
+        }
+};
+
+bool Profiler::ENABLED = false;
+int Profiler::INTERVAL = 1000;
+
+Profiler::Site* Profiler::sites = nullptr;
+volatile size_t Profiler::used = 0;
+size_t Profiler::dropped = 0, Profiler::samples = 0;
+
+std::map<std::string, size_t> Profiler::stacks;
+std::map<std::pair<std::string, int>, Profiler::Count> Profiler::lines;
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef REGISTERS_H
+#define REGISTERS_H
+
+#include <vector>
+#include <cstdint>
+
+#include "common.hpp"
+
+#define CONSTANT_FLAG 0x80000000
+
+class Registers {
+    public:
+        static bool ENABLED;
+
+        typedef struct {
+            uint8_t code;
+            uint32_t a, b, c;
+        } Instruction;
+
+        std::vector<Instruction> codes;
+        Lines lines;
+        int count = 0;
+
+        static Registers* compile(Function* function) {
+            Registers* registers = new Registers();
+            registers->translate(function);
+            return registers;
+        }
+
+    private:
+        std::vector<uint32_t> sources;
+        long last = -1;
+
+        void write(uint8_t code, uint32_t a, uint32_t b, uint32_t c, int line) {
+            this->codes.push_back({ code, a, b, c });
+            this->lines.push(line);
+        }
+
+        void result(uint8_t code, uint32_t a, uint32_t b, uint32_t c, int line) {
+            this->write(code, a, b, c, line);
+            this->sources[a] = a; this->last = this->codes.size() - 1;
+        }
+
+        void materialize(size_t slot, int line) {
+            if(this->sources[slot] == slot) return;
+
+            this->write(OP_ASSIGNMENT_LOCAL, slot, this->sources[slot], 0, line);
+            this->sources[slot] = slot;
+        }
+
+        void flush(int depth, int line) {
+            for(int i = 0; i < depth; i++) this->materialize(i, line);
+            this->last = -1;
+        }
+
+        void assign(uint32_t slot, int depth, int line) {
+            for(int i = 0; i < depth; i++)
+                if(i != (int)slot && this->sources[i] == slot) { this->materialize(i, line); this->last = -1; }
+
+            Instruction* previous = this->last >= 0 && this->last == (long)this->codes.size() - 1 ? &this->codes[this->last] : nullptr;
+
+            if(previous != nullptr && previous->a == (uint32_t)depth - 1 && this->sources[depth - 1] == (uint32_t)depth - 1 && (int)slot != depth - 1) {
+                previous->a = slot;
+                this->sources[depth - 1] = slot;
+            }
+            else if(this->sources[depth - 1] != slot) this->write(OP_ASSIGNMENT_LOCAL, slot, this->sources[depth - 1], 0, line);
+
+            this->sources[slot] = slot; this->last = -1;
+        }
+
+        void translate(Function* function) {
+            std::vector<uint8_t>& codes = function->chunk->codes;
+
+            std::vector<int> depths; std::vector<bool> labels;
+            this->count = analyze(function, &depths, &labels);
+
+            this->sources.resize(this->count);
+            for(int i = 0; i < this->count; i++) this->sources[i] = i;
+
+            std::vector<long> entries(codes.size(), -1), jumps;
+
+            for(size_t i = 0; i < codes.size(); i += 1 + operands(codes[i])) {
+                if(depths[i] == -1) continue;
+
+                ::Instruction instruction = decode(codes, i);
+                int d = depths[i], line = function->chunk->lines[i];
+
+                if(labels[i]) this->flush(d, line);
+
+                entries[i] = this->codes.size();
+
+                uint32_t* top = d > 0 ? &this->sources[d - 1] : nullptr;
+
+                switch(instruction.code) {
+                    case OP_CONSTANT: case OP_CONSTANT_LONG: this->sources[d] = CONSTANT_FLAG | instruction.operand; break;
+
+                    case OP_TRUE: case OP_FALSE: case OP_VOID: this->result(instruction.code, d, 0, 0, line); break;
+
+                    case OP_PLUS: this->write(OP_PLUS, 0, *top, 0, line); break;
+                    case OP_MINUS: case OP_NOT: this->result(instruction.code, d - 1, *top, 0, line); break;
+
+                    case OP_ADD: case OP_SUBTRACT: case OP_MULTIPLY: case OP_DIVIDE: case OP_MOD: case OP_CONCATENATE: case OP_AND: case OP_OR:
+                    case OP_EQUALS: case OP_NOT_EQUALS: case OP_GREATER: case OP_GREATER_EQUALS: case OP_LESS: case OP_LESS_EQUALS:
+                        this->result(instruction.code, d - 2, this->sources[d - 2], *top, line); break;
+
+                    case OP_PRINT: this->write(OP_PRINT, 0, *top, 0, line); break;
+                    case OP_INPUT: this->result(OP_INPUT, d, 0, 0, line); break;
+
+                    case OP_DECLARATION: case OP_DECLARATION_LONG: this->write(OP_DECLARATION, instruction.operand, *top, 0, line); break;
+                    case OP_VARIABLE: case OP_VARIABLE_LONG: this->result(OP_VARIABLE, d, instruction.operand, 0, line); break;
+                    case OP_ASSIGNMENT_VARIABLE: case OP_ASSIGNMENT_VARIABLE_LONG: this->write(OP_ASSIGNMENT_VARIABLE, instruction.operand, *top, 0, line); break;
+
+                    case OP_LOCAL: case OP_LOCAL_LONG: this->sources[d] = this->sources[instruction.operand]; break;
+                    case OP_ASSIGNMENT_LOCAL: case OP_ASSIGNMENT_LOCAL_LONG: this->assign(instruction.operand, d, line); break;
+
+                    case OP_CONDITION: case OP_CONDITION_LONG:
+                        this->flush(d, line); jumps.push_back(this->codes.size());
+                        this->write(OP_CONDITION, instruction.target, d - 1, 0, line); break;
+
+                    case OP_JUMP: case OP_JUMP_LONG: case OP_LOOP: case OP_LOOP_LONG:
+                        this->flush(d, line); jumps.push_back(this->codes.size());
+                        this->write(OP_JUMP, instruction.target, 0, 0, line); break;
+
+                    case OP_RANGE: case OP_RANGE_LONG: case OP_RANGE_LOOP: case OP_RANGE_LOOP_LONG:
+                        this->flush(d, line); jumps.push_back(this->codes.size());
+                        this->write(instruction.code == OP_RANGE || instruction.code == OP_RANGE_LONG ? OP_RANGE : OP_RANGE_LOOP, instruction.target, instruction.slot, 0, line); break;
+
+                    case OP_COUNTER: this->result(OP_COUNTER, d, instruction.operand, 0, line); break;
+
+                    case OP_CALL: case OP_TAIL_CALL:
+                        this->flush(d, line);
+                        this->write(instruction.code, d - instruction.operand - 1, instruction.operand, 0, line); break;
+
+                    case OP_RETURN: this->write(OP_RETURN, 0, *top, 0, line); break;
+                    case OP_EXIT: this->write(OP_EXIT, 0, 0, 0, line); break;
+                }
+
+                if(instruction.code == OP_JUMP || instruction.code == OP_JUMP_LONG || instruction.code == OP_LOOP || instruction.code == OP_LOOP_LONG ||
+                    instruction.code == OP_RETURN || instruction.code == OP_EXIT)
+                    for(int k = 0; k < this->count; k++) this->sources[k] = k;
+            }
+
+            for(long jump : jumps) this->codes[jump].a = entries[this->codes[jump].a];
+
+            this->sources.clear();
+        }
+};
+
+bool Registers::ENABLED = false;
+
+#endif
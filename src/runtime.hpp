@@ -0,0 +1,233 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "common.hpp"
+#include "symbol-table.hpp"
+#include "standard-library.hpp"
+
+#ifndef FRAME_MAX
+#define FRAME_MAX 1000
+#endif
+
+class Runtime {
+    public:
+        static Table globals;
+        static int depth, pending;
+        static Value next[UINT8_MAX + 1];
+
+        static const char* names[FRAME_MAX];
+        static int lines[FRAME_MAX];
+
+        static void initialize() {
+            for(auto& native : natives) Runtime::globals.insert(native.name, native.native);
+        }
+
+        static void error(RUN_TIME_ERROR error, int line) {
+            for(int i = Runtime::depth; i >= 0; i--) {
+                fprintf(stderr, "[line %d] ", i == Runtime::depth ? line : Runtime::lines[i]);
+
+                if(i == 0) fprintf(stderr, "RUN-TIME ERROR in script: ");
+                else fprintf(stderr, "in `%s` ->\n", Runtime::names[i]);
+            }
+
+            fprintf(stderr, "%s", run_time_error.find(error)->second.c_str());
+            exit(70);
+        }
+
+        static void plus(Value* value, int line) {
+            if(value->index() != VAL_NUMBER && value->index() != VAL_STRING) Runtime::error(OPERANDS_ERROR, line);
+        }
+
+        static void minus(Value* value, int line) {
+            if(value->index() == VAL_NUMBER) { Number number = value->value.number; *value = -number; return; }
+            if(value->index() == VAL_STRING) { String string = value->value.string; *value = -string; return; }
+
+            Runtime::error(OPERANDS_ERROR, line);
+        }
+
+        static void negation(Value* value, int line) {
+            if(value->index() != VAL_BOOLEAN) Runtime::error(OPERANDS_ERROR, line);
+            Boolean boolean = value->value.boolean; *value = !boolean;
+        }
+
+        template<uint8_t INSTRUCTION>
+        static void binary(Value* left, int line) {
+            Value* right = left + 1;
+
+            if(left->index() == VAL_NUMBER && right->index() == VAL_NUMBER) {
+                Number a = left->value.number, b = right->value.number;
+
+                switch(INSTRUCTION) {
+                    case OP_ADD: *left = a + b; return;
+                    case OP_SUBTRACT: *left = a - b; return;
+                    case OP_MULTIPLY: *left = a * b; return;
+                    case OP_DIVIDE: *left = a / b; return;
+                    case OP_MOD: *left = a % b; return;
+                }
+            }
+
+            if(left->index() == VAL_STRING && right->index() == VAL_STRING) {
+                String a = left->value.string, b = right->value.string;
+
+                switch(INSTRUCTION) {
+                    case OP_ADD: *left = a + b; return;
+                    case OP_CONCATENATE: *left = String::CONCATENATE(a, b); return;
+                }
+            }
+
+            if(left->index() == VAL_BOOLEAN && right->index() == VAL_BOOLEAN) {
+                Boolean a = left->value.boolean, b = right->value.boolean;
+
+                switch(INSTRUCTION) {
+                    case OP_AND: *left = a && b; return;
+                    case OP_OR: *left = a || b; return;
+                }
+            }
+
+            Runtime::error(OPERANDS_ERROR, line);
+        }
+
+        template<uint8_t INSTRUCTION>
+        static void comparison(Value* left, int line) {
+            Value* right = left + 1; bool result;
+
+            #define COMPARE(type, tag) do { \
+                    type a = left->value.tag, b = right->value.tag; \
+                    switch(INSTRUCTION) { \
+                        case OP_EQUALS: result = a == b; break; case OP_NOT_EQUALS: result = a != b; break; \
+                        case OP_GREATER: result = a > b; break; case OP_GREATER_EQUALS: result = a >= b; break; \
+                        case OP_LESS: result = a < b; break; case OP_LESS_EQUALS: result = a <= b; break; \
+                    } \
+                } while(false)
+
+            if(left->index() == VAL_NUMBER && right->index() == VAL_NUMBER) COMPARE(Number, number);
+            else if(left->index() == VAL_STRING && right->index() == VAL_STRING) COMPARE(String, string);
+            else if(INSTRUCTION != OP_EQUALS && INSTRUCTION != OP_NOT_EQUALS) { Runtime::error(OPERANDS_ERROR, line); return; }
+            else if(left->index() == VAL_BOOLEAN && right->index() == VAL_BOOLEAN) result = (left->value.boolean == right->value.boolean) == (INSTRUCTION == OP_EQUALS);
+            else if(left->index() == VAL_VOID && right->index() == VAL_VOID) result = INSTRUCTION == OP_EQUALS;
+            else result = INSTRUCTION == OP_NOT_EQUALS;
+
+            #undef COMPARE
+
+            *left = Boolean(result);
+        }
+
+        static void print(Value* value) {
+            switch(value->index()) {
+                case VAL_NUMBER: printf("%s\n", value->value.number.get().c_str()); break;
+                case VAL_BOOLEAN: printf("%s\n", value->value.boolean.get().c_str()); break;
+                case VAL_STRING: printf("%.*s\n", (int)value->value.string.length(), value->value.string.data()); break;
+
+                case VAL_FUNCTION: printf("<Function object: `%s`>\n", value->value.function.name.c_str()); break;
+                case VAL_NATIVE: printf("<Standard library function>\n"); break;
+
+                case VAL_VOID: printf("%s\n", Void::VOID().get().c_str()); break;
+
+                case VAL_INTEGER: printf("%s\n", Number::INTEGER(value->value.integer).get().c_str()); break;
+            }
+        }
+
+        static void input(Value* value) {
+            std::string data; std::cin >> data;
+            *value = String(data);
+        }
+
+        static void declaration(const char* identifier, Value* value, int line) {
+            if(Runtime::globals.insert(identifier, *value) == false) Runtime::error(DECLARATION_ERROR, line);
+        }
+
+        static void assignment(const char* identifier, Value* value, int line) {
+            if(Runtime::globals.set(identifier, *value) == false) Runtime::error(ASSIGNMENT_ERROR, line);
+        }
+
+        static bool condition(Value* value, int line) {
+            if(value->index() != VAL_BOOLEAN) Runtime::error(CONDITION_ERROR, line);
+            return value->value.boolean.boolean;
+        }
+
+        static bool range(Value* counter, int line) {
+            int64_t start, end;
+
+            if(counter[0].index() != VAL_NUMBER || counter[0].value.number.integral(&start) == false) Runtime::error(RANGE_ERROR, line);
+            if(counter[1].index() != VAL_NUMBER || counter[1].value.number.integral(&end) == false) Runtime::error(RANGE_ERROR, line);
+
+            counter[0] = Value(start); counter[1] = Value(end);
+
+            return start < end;
+        }
+
+        static void purity(Value* callee, int line) {
+            if(pure(callee) == false) Runtime::error(PURITY_ERROR, line);
+        }
+
+        static bool self(Value* callee, Chunk* chunk, int arguments) {
+            return callee->index() == VAL_FUNCTION && callee->value.function.chunk == chunk
+                && callee->value.function.memo == nullptr && callee->value.function.parameters == arguments;
+        }
+
+        static bool tail(Value* callee, int arguments, int line) {
+            if(callee->index() != VAL_FUNCTION || callee->value.function.memo != nullptr) return false;
+            if(callee->value.function.parameters != arguments) Runtime::error(ARGUMENTS_ERROR, line);
+
+            for(int i = 0; i <= arguments; i++) Runtime::next[i] = callee[i];
+            Runtime::pending = arguments;
+
+            return true;
+        }
+
+        static void call(Value* callee, int arguments, int line) {
+            switch(callee->index()) {
+                case VAL_FUNCTION: {
+                    Function* function = &callee->value.function;
+
+                    if(function->parameters != arguments) Runtime::error(ARGUMENTS_ERROR, line);
+                    if(Runtime::depth == FRAME_MAX - 1) Runtime::error(STACK_OVERFLOW_ERROR, line);
+
+                    std::string key; Memo* memo = nullptr;
+
+                    if(function->memo != nullptr && Memo::key(callee + 1, arguments, &key)) {
+                        if(function->memo->find(key, callee)) return;
+                        memo = function->memo;
+                    }
+
+                    Runtime::lines[Runtime::depth++] = line;
+                    Runtime::names[Runtime::depth] = function->name.c_str();
+
+                    Value result = function->chunk->compiled(callee + 1, arguments);
+
+                    while(Runtime::pending != -1) {
+                        int count = Runtime::pending; Runtime::pending = -1;
+
+                        *callee = Runtime::next[0];
+                        Runtime::names[Runtime::depth] = callee->value.function.name.c_str();
+
+                        result = callee->value.function.chunk->compiled(Runtime::next + 1, count);
+                    }
+
+                    Runtime::depth--;
+
+                    if(memo != nullptr) memo->insert(key, result);
+
+                    *callee = result; return;
+                }
+
+                case VAL_NATIVE: *callee = callee->value.native(callee + 1, arguments); return;
+
+                case VAL_INTEGER: Runtime::error(FUNCTION_ERROR, line); return;
+            }
+
+            Runtime::error(FUNCTION_ERROR, line);
+        }
+};
+
+Table Runtime::globals;
+int Runtime::depth = 0, Runtime::pending = -1;
+Value Runtime::next[UINT8_MAX + 1];
+
+const char* Runtime::names[FRAME_MAX];
+int Runtime::lines[FRAME_MAX];
+
+#endif
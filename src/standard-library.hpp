@@ -24,7 +24,27 @@ Value length(Value* arguments, int parameters) {
     if(arguments[parameters - 1].index() != VAL_STRING) return Void::VOID();
 
     String string = arguments[parameters - 1].value.string;
-    return Number(std::to_string(string.get().size()));
+    return Number::INTEGER(string.length());
+}
+
+const struct {
+    const char* name;
+    Native native;
+    bool pure;
+} natives[] = {
+    { "number", number, true },
+    { "string", string, true },
+    { "length", length, true }
+};
+
+bool pure(Value* callee) {
+    if(callee->index() == VAL_FUNCTION) return callee->value.function.memo != nullptr;
+
+    if(callee->index() == VAL_NATIVE)
+        for(auto& entry : natives)
+            if(entry.native == callee->value.native) return entry.pure;
+
+    return true;
 }
 
 #endif
\ No newline at end of file
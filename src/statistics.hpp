@@ -0,0 +1,210 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "common.hpp"
+#include "heap.hpp"
+#include "standard-library.hpp"
+
+#define STATISTICS_OUTSIDE 255
+
+class Statistics {
+    public:
+        static bool ENABLED;
+
+        typedef enum { TOKENIZE, COMPILE, RUN } Phase;
+
+        static uint64_t clock() {
+            #if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+            #else
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+            #endif
+        }
+
+        static void dispatch(uint8_t instruction) {
+            uint64_t now = Statistics::clock();
+
+            Statistics::cycles[Statistics::last] += now - Statistics::stamp;
+            Statistics::counts[instruction]++;
+
+            Statistics::stamp = now; Statistics::last = instruction;
+        }
+
+        static void settle() { Statistics::dispatch(STATISTICS_OUTSIDE); }
+
+        static void call(Value& callee) {
+            if(callee.index() == VAL_FUNCTION) {
+                Call& call = Statistics::calls[callee.value.function.chunk];
+                if(call.count++ == 0) { call.name = callee.value.function.name; call.memo = callee.value.function.memo; }
+            }
+
+            if(callee.index() == VAL_NATIVE) Statistics::natives[callee.value.native]++;
+        }
+
+        static void time(Phase phase, std::chrono::steady_clock::time_point start) {
+            Statistics::phases[phase] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        static void reset() {
+            for(int i = 0; i < 256; i++) { Statistics::counts[i] = 0; Statistics::cycles[i] = 0; }
+            for(double& phase : Statistics::phases) phase = 0;
+
+            Statistics::calls.clear(); Statistics::natives.clear();
+
+            Statistics::numbers = Number::ALLOCATIONS; Statistics::strings = Heap::allocations(); Statistics::bytes = Heap::volume();
+        }
+
+        static std::string text() {
+            char line[256]; std::string text;
+
+            snprintf(line, sizeof(line), "[stats] tokenize %.3f ms, compile %.3f ms, run %.3f ms\n", Statistics::phases[TOKENIZE], Statistics::phases[COMPILE], Statistics::phases[RUN]);
+            text += line;
+
+            snprintf(line, sizeof(line), "[stats] %zu instructions, %zu numbers created, %zu strings allocated (%zu bytes)\n",
+                Statistics::instructions(), Number::ALLOCATIONS - Statistics::numbers, Heap::allocations() - Statistics::strings, Heap::volume() - Statistics::bytes);
+            text += line;
+
+            for(int i : Statistics::opcodes()) {
+                snprintf(line, sizeof(line), "[stats] %-26s %12zu executed %14llu cycles %8.1f per instruction\n", mnemonics[i], Statistics::counts[i],
+                    (unsigned long long)Statistics::cycles[i], (double)Statistics::cycles[i] / Statistics::counts[i]);
+                text += line;
+            }
+
+            for(Call& call : Statistics::functions()) {
+                if(call.memo != nullptr) snprintf(line, sizeof(line), "[stats] %-26s %12zu calls %12d cache hits %12d misses\n", call.name.c_str(), call.count, call.memo->hits, call.memo->misses);
+                else snprintf(line, sizeof(line), "[stats] %-26s %12zu calls\n", call.name.c_str(), call.count);
+                text += line;
+            }
+
+            for(auto& entry : Statistics::natives) {
+                snprintf(line, sizeof(line), "[stats] %-26s %12zu native calls\n", Statistics::name(entry.first), entry.second);
+                text += line;
+            }
+
+            return text;
+        }
+
+        static std::string json() {
+            char field[256]; std::string json;
+
+            snprintf(field, sizeof(field), "{\"phases\":{\"tokenize\":%.3f,\"compile\":%.3f,\"run\":%.3f},", Statistics::phases[TOKENIZE], Statistics::phases[COMPILE], Statistics::phases[RUN]);
+            json += field;
+
+            snprintf(field, sizeof(field), "\"instructions\":%zu,\"allocations\":{\"numbers\":%zu,\"strings\":%zu,\"bytes\":%zu},\"opcodes\":{",
+                Statistics::instructions(), Number::ALLOCATIONS - Statistics::numbers, Heap::allocations() - Statistics::strings, Heap::volume() - Statistics::bytes);
+            json += field;
+
+            std::string separator = "";
+
+            for(int i : Statistics::opcodes()) {
+                snprintf(field, sizeof(field), "\"%s\":{\"count\":%zu,\"cycles\":%llu}", mnemonics[i], Statistics::counts[i], (unsigned long long)Statistics::cycles[i]);
+                json += separator + field; separator = ",";
+            }
+
+            json += "},\"functions\":["; separator = "";
+
+            for(Call& call : Statistics::functions()) {
+                json += separator + "{\"name\":" + Statistics::quote(call.name) + ",\"calls\":" + std::to_string(call.count);
+                if(call.memo != nullptr) json += ",\"hits\":" + std::to_string(call.memo->hits) + ",\"misses\":" + std::to_string(call.memo->misses);
+                json += "}";
+                separator = ",";
+            }
+
+            json += "],\"natives\":{"; separator = "";
+
+            for(auto& entry : Statistics::natives) {
+                json += separator + Statistics::quote(Statistics::name(entry.first)) + ":" + std::to_string(entry.second);
+                separator = ",";
+            }
+
+            return json + "}}\n";
+        }
+
+        static std::string quote(const std::string& text) {
+            std::string quoted = "\"";
+
+            for(char character : text) {
+                if(character == '"' || character == '\\') quoted += '\\';
+                quoted += character;
+            }
+
+            return quoted + "\"";
+        }
+
+    private:
+        typedef struct {
+            std::string name;
+            size_t count;
+            Memo* memo;
+        } Call;
+
+        static size_t counts[256];
+        static uint64_t cycles[256], stamp;
+        static uint8_t last;
+        static double phases[3];
+
+        static std::unordered_map<Chunk*, Call> calls;
+        static std::unordered_map<Native, size_t> natives;
+
+        static size_t numbers, strings, bytes;
+
+        static size_t instructions() {
+            size_t total = 0;
+            for(int i = 0; i < STATISTICS_OUTSIDE; i++) total += Statistics::counts[i];
+
+            return total;
+        }
+
+        static std::vector<int> opcodes() {
+            std::vector<int> opcodes;
+
+            for(int i = 0; i < (int)(sizeof(mnemonics) / sizeof(mnemonics[0])); i++)
+                if(Statistics::counts[i] > 0) opcodes.push_back(i);
+
+            std::sort(opcodes.begin(), opcodes.end(), [](int left, int right) { return Statistics::cycles[left] > Statistics::cycles[right]; });
+
+            return opcodes;
+        }
+
+        static std::vector<Call> functions() {
+            std::vector<Call> functions;
+
+            for(auto& entry : Statistics::calls) functions.push_back(entry.second);
+            std::sort(functions.begin(), functions.end(), [](Call& left, Call& right) { return left.count > right.count; });
+
+            return functions;
+        }
+
+        static const char* name(Native native) {
+            for(auto& entry : ::natives)
+                if(entry.native == native) return entry.name;
+
+            return "native";
+        }
+
+};
+
+bool Statistics::ENABLED = false;
+
+size_t Statistics::counts[256] = {};
+uint64_t Statistics::cycles[256] = {}, Statistics::stamp = 0;
+uint8_t Statistics::last = STATISTICS_OUTSIDE;
+double Statistics::phases[3] = {};
+
+std::unordered_map<Chunk*, Statistics::Call> Statistics::calls;
+std::unordered_map<Native, size_t> Statistics::natives;
+
+size_t Statistics::numbers = 0, Statistics::strings = 0, Statistics::bytes = 0;
+
+#endif
@@ -1,128 +1,147 @@
 #ifndef SYMBOL_TABLE_H
 #define SYMBOL_TABLE_H
 
-#include "common.hpp"
+#include <string_view>
+#include <utility>
 
-#define LOAD_FACTOR 0.75
+#include "common.hpp"
 
-class NODE { 
-    public: 
-        std::string key; Value value; 
-        
-        NODE(std::string key, Value value) { 
-            this->key = key; 
-            this->value = value; 
-        } 
-};
+#define LOAD_FACTOR 0.875
+#define EMPTY_SLOT -1
 
 class Table {
-    public:        
-        ~Table() { delete[] this->array; }
+    public:
+        ~Table() { delete[] this->slots; }
 
         Table() {
-            this->array = new NODE*[this->capacity];
-            
-            for(int i = 0; i < this->capacity; i++) 
-                this->array[i] = nullptr;
+            this->slots = new Slot[this->capacity];
+            for(size_t i = 0; i < this->capacity; i++) this->slots[i].distance = EMPTY_SLOT;
         }
 
-        bool insert(std::string key, Value value) {
-            NODE* temp = new NODE(key, value);
-            int index = this->hash(key);
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+
+        bool insert(std::string_view key, Value value) { return this->insert(key, String::fnv(key.data(), key.size()), value); }
+        bool insert(String& key, Value value) { return this->insert(std::string_view(key.data(), key.length()), key.hash(), value); }
+
+        Value get(std::string_view key) { return this->get(key, String::fnv(key.data(), key.size())); }
+        Value get(String& key) { return this->get(std::string_view(key.data(), key.length()), key.hash()); }
+
+        bool set(std::string_view key, Value value) { return this->set(key, String::fnv(key.data(), key.size()), value); }
+        bool set(String& key, Value value) { return this->set(std::string_view(key.data(), key.length()), key.hash(), value); }
+
+        bool remove(std::string_view key) {
+            long index = this->find(key, String::fnv(key.data(), key.size()));
+            if(index == -1) return false;
+
+            uint32_t entry = this->slots[index].entry;
+            size_t mask = this->capacity - 1, hole = index, next = (hole + 1) & mask;
 
-            while(this->array[index] != nullptr) {
-                if(this->array[index]->key == key) return false;
+            while(this->slots[next].distance > 0) {
+                this->slots[hole] = this->slots[next];
+                this->slots[hole].distance--;
 
-                index++;
-                index %= this->capacity;
+                hole = next; next = (next + 1) & mask;
             }
 
-            if(this->array[index] == nullptr) this->count++;
-            this->array[index] = temp;
+            this->slots[hole].distance = EMPTY_SLOT;
 
-            if(this->count + 1 > this->capacity * LOAD_FACTOR) this->fix();
+            if(entry != this->records.size() - 1) {
+                size_t last = this->records.size() - 1, moved = this->records[last].hash & mask;
+                while(this->slots[moved].entry != last || this->slots[moved].distance == EMPTY_SLOT) moved = (moved + 1) & mask;
+
+                this->slots[moved].entry = entry;
+                this->records[entry] = std::move(this->records[last]);
+            }
+
+            this->records.pop_back();
 
             return true;
         }
 
-        bool remove(std::string key) {
-            int index = this->hash(key);
+        std::vector<std::pair<std::string, Value>> entries() {
+            std::vector<std::pair<std::string, Value>> entries;
+
+            for(Entry& entry : this->records) entries.push_back({ entry.key, entry.value });
+
+            return entries;
+        }
+
+    private:
+        typedef struct {
+            uint64_t hash;
+            uint32_t entry;
+            int32_t distance;
+        } Slot;
+
+        typedef struct {
+            std::string key;
+            uint64_t hash;
+            Value value;
+        } Entry;
+
+        Slot* slots;
+        size_t capacity = 16;
+
+        std::vector<Entry> records;
 
-            while(this->array[index] != nullptr) {
-                if(this->array[index]->key == key) {
-                    this->array[index] = nullptr; this->count--; 
-                    return true;
-                }
+        long find(std::string_view key, uint64_t hash) {
+            size_t mask = this->capacity - 1, index = hash & mask;
 
-                index++;
-                index %= this->capacity;
+            for(int32_t distance = 0; distance <= this->slots[index].distance; distance++) {
+                if(this->slots[index].hash == hash && this->records[this->slots[index].entry].key == key) return index;
+                index = (index + 1) & mask;
             }
 
-            return false;
+            return -1;
         }
 
-        Value get(std::string key) {
-            int index = this->hash(key); 
-            int counter = 0; 
-  
-            while(this->array[index] != nullptr) {    
-                if(counter++ > this->capacity) return Void::VOID();          
-                if(this->array[index]->key == key) return this->array[index]->value; 
-
-                index++; 
-                index %= this->capacity; 
-            } 
-            
-            return Void::VOID(); 
-        }
+        bool insert(std::string_view key, uint64_t hash, Value value) {
+            if(this->find(key, hash) != -1) return false;
 
-        bool set(std::string key, Value value) {
-            int index = this->hash(key); 
+            if(this->records.size() + 1 > this->capacity * LOAD_FACTOR) this->fix();
 
-            while(this->array[index] != nullptr) {    
-                if(this->array[index]->key == key) {
-                    this->array[index]->value = value; 
-                    return true;
-                }
+            this->place({ hash, (uint32_t)this->records.size(), 0 });
+            this->records.push_back({ std::string(key), hash, value });
 
-                index++; 
-                index %= this->capacity; 
-            } 
-            
-            return false; 
+            return true;
         }
 
-    private:
-        NODE **array;
-        int capacity = 10, count = 0;
+        Value get(std::string_view key, uint64_t hash) {
+            long index = this->find(key, hash);
+            return index == -1 ? Void::VOID() : this->records[this->slots[index].entry].value;
+        }
 
-        int hash(std::string string) {
-            int ascii = 0; 
-            for (int i = 0; i < string.length(); i++) ascii += string[i]; 
-            return (ascii % this->capacity); 
+        bool set(std::string_view key, uint64_t hash, Value value) {
+            long index = this->find(key, hash);
+            if(index == -1) return false;
+
+            this->records[this->slots[index].entry].value = value;
+            return true;
         }
 
-        void fix() {
-            NODE **temp = new NODE*[this->count];
+        void place(Slot slot) {
+            size_t mask = this->capacity - 1, index = slot.hash & mask;
 
-            for(int i = 0, k = 0; i < this->capacity; i++) 
-                if(this->array[i] != nullptr) { temp[k] = this->array[i]; k++; }
+            while(this->slots[index].distance != EMPTY_SLOT) {
+                if(this->slots[index].distance < slot.distance) std::swap(this->slots[index], slot);
 
-            this->capacity = this->capacity * 2;
-            this->array = new NODE*[this->capacity];
+                slot.distance++;
+                index = (index + 1) & mask;
+            }
 
-            for(int i = 0; i < this->count; i++) {
-                NODE* populate = new NODE(temp[i]->key, temp[i]->value);
-                int index = this->hash(temp[i]->key);
+            this->slots[index] = slot;
+        }
+
+        void fix() {
+            delete[] this->slots;
 
-                while(this->array[index] != nullptr) {
-                    index++;
-                    index %= this->capacity;
-                }
+            this->capacity *= 2;
+            this->slots = new Slot[this->capacity];
 
-                this->array[index] = populate;
-            } 
+            for(size_t i = 0; i < this->capacity; i++) this->slots[i].distance = EMPTY_SLOT;
+            for(size_t i = 0; i < this->records.size(); i++) this->place({ this->records[i].hash, (uint32_t)i, 0 });
         }
 };
 
-#endif
\ No newline at end of file
+#endif
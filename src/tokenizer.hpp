@@ -2,9 +2,11 @@
 #define TOKENIZER_H
 
 #include <utility> 
-#include <map>
+#include <string>
+#include <string_view>
+#include <cstring>
 
-#define TOKEN_NUMBER 52
+#define TOKEN_NUMBER 55
 
 enum Types { 
     END_OF_FILE, END_OF_LINE, ERROR, EMPTY, EXIT,
@@ -16,39 +18,67 @@ enum Types {
     AND, OR, NOT,
     EQUALS, NOT_EQUALS, 
     GREATER, LESS, GREATER_EQUALS, LESS_EQUALS,
-    COMMA, COLON,
+    COMMA, COLON, RANGE,
     OPEN_PARENTHESES, CLOSE_PARENTHESES,
     OPEN_BRACES, CLOSE_BRACES,
     ASSIGN, PLUS_ASSIGN, MINUS_ASSIGN, ASTERISK_ASSIGN, SLASH_ASSIGN, MOD_ASSIGN,
     INCREMENT, DECREMENT,
     SET, GET, PRINT,
-    IF, ELSE, WHILE, FOR,
-    DEFINE, INVOKE, RETURN,
+    IF, ELSE, WHILE, FOR, IN,
+    DEFINE, PURE, INVOKE, RETURN,
     SEMICOLON 
 };
 
-const std::map<std::string, Types> keywords = {
+const struct {
+    const char* word;
+    Types type;
+} keywords[] = {
     {"empty", EMPTY}, {"exit", EXIT},
     {"set", SET}, {"get", GET},
     {"print", PRINT},
     {"void", VOID},
     {"true", BOOLEAN_TRUE}, {"false", BOOLEAN_FALSE},
     {"and", AND}, {"or", OR}, {"not", NOT}, {"is", EQUALS},
-    {"if", IF}, {"else", ELSE}, {"while", WHILE}, {"for", FOR},
-    {"define", DEFINE}, {"return", RETURN}, {"invoke", INVOKE}
+    {"if", IF}, {"else", ELSE}, {"while", WHILE}, {"for", FOR}, {"in", IN},
+    {"define", DEFINE}, {"pure", PURE}, {"return", RETURN}, {"invoke", INVOKE}
 };
 
+#define KEYWORD_HASH(word, length) (((length) + (unsigned char)(word)[0] + 3 * (unsigned char)(word)[(length) - 1]) & 63)
+
+Types keyword(const char* word, size_t length) {
+    static int8_t table[64] = { 0 };
+
+    if(table[KEYWORD_HASH(keywords[0].word, strlen(keywords[0].word))] == 0)
+        for(size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) table[KEYWORD_HASH(keywords[i].word, strlen(keywords[i].word))] = i + 1;
+
+    int index = table[KEYWORD_HASH(word, length)] - 1;
+
+    if(index == -1 || strncmp(keywords[index].word, word, length) != 0 || keywords[index].word[length] != '\0') return IDENTIFIER;
+
+    return keywords[index].type;
+}
+
 typedef struct {
     Types type;
-    std::string content;
+    std::string_view content;
     int line;
 } Token;
 
 class Tokenizer {
     public:
-        Tokenizer(std::string source) {
-            this->source = source;
-            this->current = this->source[this->pos];
+        typedef struct {
+            int line, start, pos;
+            char current;
+        } State;
+
+        Tokenizer(std::string source) : owned(std::move(source)) {
+            this->source = this->owned.data(); this->length = this->owned.size();
+            this->current = this->length > 0 ? this->source[0] : '\0';
+        }
+
+        Tokenizer(const char* source, size_t length) {
+            this->source = source; this->length = length;
+            this->current = this->length > 0 ? this->source[0] : '\0';
         }
 
         Token next() {
@@ -67,7 +97,7 @@ class Tokenizer {
                 if(this->peek("/*")) { 
                     this->advance(2); 
 
-                    while(this->peek("*/") == false) {
+                    while(this->peek("*/") == false && this->current != '\0') {
                         if(this->current == '\n') this->line++;
                         this->advance(); 
                     }
@@ -78,7 +108,7 @@ class Tokenizer {
                 goto START;
             }
 
-            if(this->pos >= this->source.length()) { this->line++; return make(END_OF_FILE, "EOF"); }
+            if(this->pos >= this->length) { this->line++; return make(END_OF_FILE, "EOF"); }
 
             if(this->current == '"' || this->current == '\'' || this->current == '`') {
                 char quote = this->current; this->advance();
@@ -89,6 +119,8 @@ class Tokenizer {
 
             this->start = this->pos;
 
+            if(this->peek("..")) { this->advance(2); return make(RANGE); }
+
             if(isalpha(this->current) || this->current == '_' || this->current == '$') return this->word();
             if(isdigit(this->current) || this->current == '.') return this->number();
 
@@ -138,55 +170,51 @@ class Tokenizer {
             return make(ERROR, "Unexpected or Wrong character");
         }
 
+        State save() { return { this->line, this->start, this->pos, this->current }; }
+
+        void restore(State state) {
+            this->line = state.line; this->start = state.start; this->pos = state.pos;
+            this->current = state.current;
+        }
+
     private:
         int line = 1;
-        std::string source; char current;
+        std::string owned;
+        const char* source; size_t length; char current;
         int start = 0, pos = 0;
 
-        Token make(Types type, std::string message = "") {                
+        Token make(Types type, std::string_view message = "") {                
             Token token;                                          
             token.type = type;                                    
-            token.content = message.empty() ? this->source.substr(this->start, this->pos - this->start) : message;
+            token.content = message.empty() ? std::string_view(this->source + this->start, this->pos - this->start) : message;
             token.line = this->line;
 
             return token;                                         
         } 
 
-        bool peek(std::string token) {
-            for(int i = 0, peek = this->pos; i < token.length(); i++, peek++) 
-                if(token[i] != this->source[peek]) 
-                    return false;         
-
-            return true;
+        bool peek(const char token[3]) {
+            return this->pos + 1 < (int)this->length && this->source[this->pos] == token[0] && this->source[this->pos + 1] == token[1];
         }
 
         void advance(int advance = 1) {
-            for(int i = 0; i < advance; i++) {
+            for(int i = 0; i < advance && this->pos < (int)this->length; i++) {
                 this->pos++;
 
-                if (this->pos == this->source.length()) { this->current = '\0'; break; }
+                if (this->pos >= (int)this->length) { this->current = '\0'; break; }
                 else this->current = this->source[this->pos];     
             }
         }
 
         Token word() {
-            std::string result;
-
-            while(isalpha(this->current) || isdigit(this->current) || this->current == '_' || this->current == '$') {
-                result += this->current;
-                this->advance();
-            }
-
-            auto keyword = keywords.find(result);
+            while(isalpha(this->current) || isdigit(this->current) || this->current == '_' || this->current == '$') this->advance();
 
-            if(keyword != keywords.end()) return make(keyword->second);
-            else return make(IDENTIFIER);
+            return make(keyword(this->source + this->start, this->pos - this->start));
         }
 
         Token number() {
             while(isdigit(this->current)) this->advance();
 
-            if(this->current == '.') {
+            if(this->current == '.' && this->peek("..") == false) {
                 this->advance();
                 while(isdigit(this->current)) this->advance();
             }
@@ -195,10 +223,10 @@ class Tokenizer {
         }
 
         Token string(char quote) {
-            while(this->current != quote && this->current != '\n') 
+            while(this->current != quote && this->current != '\n' && this->pos < (int)this->length) 
                 this->advance();
 
-            if(this->current == '\n') 
+            if(this->current != quote) 
                 return make(ERROR, "Unterminated String, expected closing quote");
 
             Token token = make(STRING); this->advance();
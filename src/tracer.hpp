@@ -0,0 +1,111 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <unordered_map>
+
+#include "common.hpp"
+#include "standard-library.hpp"
+#include "statistics.hpp"
+
+#define TRACER_EVENTS (1 << 20)
+
+class Tracer {
+    public:
+        static bool ENABLED;
+        static size_t CAPACITY;
+
+        static uint32_t name(const std::string& name) {
+            auto entry = Tracer::indexes.find(name);
+            if(entry != Tracer::indexes.end()) return entry->second;
+
+            Tracer::names.push_back(name);
+            return Tracer::indexes[name] = Tracer::names.size() - 1;
+        }
+
+        static void begin(uint32_t name) { Tracer::record(name, 'B'); Tracer::open++; }
+        static void end() { if(Tracer::open > 0) { Tracer::record(0, 'E'); Tracer::open--; } }
+
+        static void begin(Value& callee) {
+            const void* key = callee.index() == VAL_FUNCTION ? (const void*)callee.value.function.chunk : (const void*)callee.value.native;
+
+            auto entry = Tracer::callees.find(key);
+            if(entry == Tracer::callees.end()) entry = Tracer::callees.insert({ key, Tracer::name(Tracer::label(callee)) }).first;
+
+            Tracer::begin(entry->second);
+        }
+
+        static void unwind() { while(Tracer::open > 0) Tracer::end(); }
+
+        static bool write(std::string path) {
+            FILE* file = fopen(path.c_str(), "w");
+            if(file == nullptr) return false;
+
+            size_t first = Tracer::head > Tracer::CAPACITY ? Tracer::head - Tracer::CAPACITY : 0;
+
+            fprintf(file, "{\"traceEvents\":[\n");
+
+            for(size_t i = first; i < Tracer::head; i++) {
+                Event* event = &Tracer::events[i % Tracer::CAPACITY];
+
+                std::string name = event->phase == 'B' ? "\"name\":" + Statistics::quote(Tracer::names[event->name]) + "," : "";
+                fprintf(file, "%s{%s\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":1}", i > first ? ",\n" : "", name.c_str(), event->phase, event->timestamp / 1000.0);
+            }
+
+            fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%zu}}\n", first);
+
+            return fclose(file) == 0;
+        }
+
+    private:
+        typedef struct {
+            uint64_t timestamp;
+            uint32_t name;
+            char phase;
+        } Event;
+
+        static Event* events;
+        static size_t head, open;
+
+        static std::chrono::steady_clock::time_point epoch;
+
+        static std::vector<std::string> names;
+        static std::unordered_map<std::string, uint32_t> indexes;
+        static std::unordered_map<const void*, uint32_t> callees;
+
+        static void record(uint32_t name, char phase) {
+            if(Tracer::events == nullptr) { Tracer::events = new Event[Tracer::CAPACITY]; Tracer::epoch = std::chrono::steady_clock::now(); }
+
+            Event* event = &Tracer::events[Tracer::head++ % Tracer::CAPACITY];
+
+            event->timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Tracer::epoch).count();
+            event->name = name; event->phase = phase;
+        }
+
+        static std::string label(Value& callee) {
+            if(callee.index() == VAL_FUNCTION) return callee.value.function.name;
+
+            for(auto& entry : natives)
+                if(entry.native == callee.value.native) return entry.name;
+
+            return "native";
+        }
+};
+
+bool Tracer::ENABLED = false;
+size_t Tracer::CAPACITY = TRACER_EVENTS;
+
+Tracer::Event* Tracer::events = nullptr;
+size_t Tracer::head = 0, Tracer::open = 0;
+
+std::chrono::steady_clock::time_point Tracer::epoch;
+
+std::vector<std::string> Tracer::names = { "" };
+std::unordered_map<std::string, uint32_t> Tracer::indexes;
+std::unordered_map<const void*, uint32_t> Tracer::callees;
+
+#endif
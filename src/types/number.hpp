@@ -6,12 +6,32 @@
 #include <vector> 
 #include <algorithm> 
 #include <string>
+#include <cstdint>
+
+#include "../allocations.hpp"
+#include "../probes.hpp"
+
+#define NUMBER_CACHE_MIN -128
+#define NUMBER_CACHE_MAX 1024
+#define NUMBER_PROBE_DIGITS 64
 
 class Number {
     public:
         static int DIVISION_PRECISION;
+        static size_t ALLOCATIONS;
         static const Number INFINITE, NOT_A_NUMBER;
 
+        static Number INTEGER(int64_t value) {
+            static std::vector<Number> cache;
+
+            if(cache.empty()) for(int64_t i = NUMBER_CACHE_MIN; i <= NUMBER_CACHE_MAX; i++) cache.push_back(Number::integral(i));
+            if(value >= NUMBER_CACHE_MIN && value <= NUMBER_CACHE_MAX) return cache[value - NUMBER_CACHE_MIN];
+
+            if(Allocations::COUNTING) { Number::ALLOCATIONS++; if(Allocations::ENABLED) Allocations::allocate(Allocations::NUMBER, sizeof(Number)); }
+
+            return Number::integral(value);
+        }
+
         Number() = default;
         Number(std::string number) { this->set(number); }
         Number(Number* number) { 
@@ -22,6 +42,8 @@ class Number {
         void operator=(const std::string& number) { this->set(number); }
 
         void set(std::string num) {
+            if(Allocations::COUNTING) { Number::ALLOCATIONS++; if(Allocations::ENABLED) Allocations::allocate(Allocations::NUMBER, sizeof(Number)); }
+
             this->is_negative = false;
             this->integer = "";
             this->is_decimal = false; this->decimal = "";
@@ -75,6 +97,15 @@ class Number {
 
         friend std::ostream & operator << (std::ostream &out, Number& self) { out << self.get(); return out; }
 
+        bool integral(int64_t* value) {
+            if(!this->decimal.empty() || this->integer == "NaN" || this->integer == "INFINITE" || this->integer.length() > 18) return false;
+
+            *value = this->integer.empty() ? 0 : std::stoll(this->integer);
+            if(this->is_negative) *value = -*value;
+
+            return true;
+        }
+
         Number operator+() { return *this; }
         Number operator-() {
            Number result(this);
@@ -86,7 +117,7 @@ class Number {
         bool operator!=(Number& num) { return (this->integer != num.integer) || (this->decimal != num.decimal); }  
 
         bool operator<(Number& num) {
-            Number self(this);
+            Number& self = *this;
 
             if(self == num) return false;
 
@@ -102,15 +133,11 @@ class Number {
             std::string left_integer = self.integer, left_decimal = self.decimal;
             std::string right_integer = num.integer, right_decimal = num.decimal;
             
-            while(left_integer.length() != right_integer.length()) {
-                if(left_integer.length() < right_integer.length()) left_integer = "0" + left_integer;
-                else right_integer = "0" + right_integer;
-            }
+            if(left_integer.length() < right_integer.length()) left_integer.insert(0, right_integer.length() - left_integer.length(), '0');
+            else right_integer.insert(0, left_integer.length() - right_integer.length(), '0');
 
-            while(left_decimal.length() != right_decimal.length()) {
-                if(left_decimal.length() < right_decimal.length()) left_decimal += "0";
-                else right_decimal += "0";
-            }
+            if(left_decimal.length() < right_decimal.length()) left_decimal.append(right_decimal.length() - left_decimal.length(), '0');
+            else right_decimal.append(left_decimal.length() - right_decimal.length(), '0');
 
             std::string left = left_integer + left_decimal, right = right_integer + right_decimal;
 
@@ -126,17 +153,19 @@ class Number {
             return neg ? true : false; 
         }    
 
-        bool operator>(Number& num) { Number self(this); if(self == num) return false; else return !(self < num); }  
+        bool operator>(Number& num) { if(*this == num) return false; else return !(*this < num); }  
 
-        bool operator<=(Number& num) { Number self(this); if(self == num) return true; else return self < num; }  
-        bool operator>=(Number& num) { Number self(this); if(self == num) return true; else return !(self < num); }  
+        bool operator<=(Number& num) { if(*this == num) return true; else return *this < num; }  
+        bool operator>=(Number& num) { if(*this == num) return true; else return !(*this < num); }  
 
         Number operator+(Number& num) {
-            Number self(this);
+            Number& self = *this;
 
             if(self.integer == "NaN" || num.integer == "NaN") return Number::NOT_A_NUMBER;
             if(self.integer == "INFINITE" || num.integer == "INFINITE") return Number::INFINITE;
 
+            Number::probe('+', self, num);
+
             bool neg = false;
 
             if(self.is_negative && num.is_negative) neg = true;
@@ -162,15 +191,11 @@ class Number {
             std::string left_integer = self.integer, left_decimal = self.decimal;
             std::string right_integer = num.integer, right_decimal = num.decimal;
             
-            while(left_integer.length() != right_integer.length()) {
-                if(left_integer.length() < right_integer.length()) left_integer = "0" + left_integer;
-                else right_integer = "0" + right_integer;
-            }
+            if(left_integer.length() < right_integer.length()) left_integer.insert(0, right_integer.length() - left_integer.length(), '0');
+            else right_integer.insert(0, left_integer.length() - right_integer.length(), '0');
 
-            while(left_decimal.length() != right_decimal.length()) {
-                if(left_decimal.length() < right_decimal.length()) left_decimal += "0";
-                else right_decimal += "0";
-            }
+            if(left_decimal.length() < right_decimal.length()) left_decimal.append(right_decimal.length() - left_decimal.length(), '0');
+            else right_decimal.append(left_decimal.length() - right_decimal.length(), '0');
 
             std::string left = left_integer + left_decimal, right = right_integer + right_decimal;
 
@@ -204,11 +229,13 @@ class Number {
         }
 
         Number operator-(Number& num) {
-            Number self(this);
+            Number& self = *this;
 
             if(self.integer == "NaN" || num.integer == "NaN") return Number::NOT_A_NUMBER;
             if(self.integer == "INFINITE" || num.integer == "INFINITE") return Number::INFINITE;
 
+            Number::probe('-', self, num);
+
             bool neg = false;
 
             if(self.is_negative && num.is_negative) {
@@ -239,15 +266,11 @@ class Number {
             std::string left_integer = self.integer, left_decimal = self.decimal;
             std::string right_integer = num.integer, right_decimal = num.decimal;
             
-            while(left_integer.length() != right_integer.length()) {
-                if(left_integer.length() < right_integer.length()) left_integer = "0" + left_integer;
-                else right_integer = "0" + right_integer;
-            }
+            if(left_integer.length() < right_integer.length()) left_integer.insert(0, right_integer.length() - left_integer.length(), '0');
+            else right_integer.insert(0, left_integer.length() - right_integer.length(), '0');
 
-            while(left_decimal.length() != right_decimal.length()) {
-                if(left_decimal.length() < right_decimal.length()) left_decimal += "0";
-                else right_decimal += "0";
-            }
+            if(left_decimal.length() < right_decimal.length()) left_decimal.append(right_decimal.length() - left_decimal.length(), '0');
+            else right_decimal.append(left_decimal.length() - right_decimal.length(), '0');
 
             std::string left = left_integer + left_decimal, right = right_integer + right_decimal;
 
@@ -290,11 +313,13 @@ class Number {
         }
 
         Number operator*(Number& num) {
-            Number self(this);
+            Number& self = *this;
         
             if(self.integer == "NaN" || num.integer == "NaN") return Number::NOT_A_NUMBER;
             if(self.integer == "INFINITE" || num.integer == "INFINITE") return Number::INFINITE;
 
+            Number::probe('*', self, num);
+
             bool neg = false;
             if(self.is_negative ^ num.is_negative) neg = true;
 
@@ -354,11 +379,13 @@ class Number {
         }
 
         Number operator/(Number& num) {
-            Number self(this); Number zero;
+            Number& self = *this; Number zero;
             
             if(self.integer == "NaN" || num.integer == "NaN") return Number::NOT_A_NUMBER;
             if(self.integer == "INFINITE" || num.integer == "INFINITE") return Number::INFINITE;
 
+            Number::probe('/', self, num);
+
             if(self == zero ^ num == zero) {
                 if(self == zero) return zero;
                 if(num == zero) return Number::NOT_A_NUMBER;
@@ -371,10 +398,8 @@ class Number {
 
             std::string left_decimal = self.decimal, right_decimal = num.decimal;
 
-            while(left_decimal.length() != right_decimal.length()) {
-                if(left_decimal.length() < right_decimal.length()) left_decimal += "0";
-                else right_decimal += "0";
-            }
+            if(left_decimal.length() < right_decimal.length()) left_decimal.append(right_decimal.length() - left_decimal.length(), '0');
+            else right_decimal.append(left_decimal.length() - right_decimal.length(), '0');
 
             Number left(self.integer + left_decimal), right(num.integer + right_decimal);
             Number result; 
@@ -421,11 +446,13 @@ class Number {
         }
 
         Number operator%(Number& num) {
-            Number self(this);
+            Number& self = *this;
         
             if(self.integer == "NaN" || num.integer == "NaN") return Number::NOT_A_NUMBER;
             if(self.integer == "INFINITE" || num.integer == "INFINITE") return Number::INFINITE;
 
+            Number::probe('%', self, num);
+
             bool neg = num.is_negative;
 
             Number zero;
@@ -441,9 +468,26 @@ class Number {
     private:
         std::string integer; std::string decimal;
         bool is_negative = false; bool is_decimal = false; 
+
+        static void probe([[maybe_unused]] char operation, [[maybe_unused]] Number& left, [[maybe_unused]] Number& right) {
+            #ifdef PROBES_SUPPORTED
+            size_t l = left.integer.size() + left.decimal.size(), r = right.integer.size() + right.decimal.size();
+            if(l + r >= NUMBER_PROBE_DIGITS) PROBE3(number__operation, operation, l, r);
+            #endif
+        }
+
+        static Number integral(int64_t value) {
+            Number number;
+
+            if(value != 0) number.integer = std::to_string(value < 0 ? -(uint64_t)value : (uint64_t)value);
+            number.is_negative = value < 0;
+
+            return number;
+        }
 };
 
 int Number::DIVISION_PRECISION = 20;
+size_t Number::ALLOCATIONS = 0;
 const Number Number::INFINITE = Number("INFINITE");
 const Number Number::NOT_A_NUMBER = Number("NaN");
 
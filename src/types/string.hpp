@@ -3,64 +3,155 @@
 
 #include <iostream>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <unordered_set>
+#include <unordered_map>
+
+#include "../heap.hpp"
+
+#define STRING_BUILDER 64
 
 class String {
     public:
         String() = default;
         String(std::string content) { this->set(content); }
-        String(String* copy) { this->content = copy->content; }
+        String(String* copy) { this->content = copy->content; this->size = copy->size; }
 
         void operator=(const std::string& str) { this->set(str); }
 
         friend std::ostream & operator << (std::ostream &out, String &self) { out << '"' << self.get() << '"'; return out; }
 
-        std::string get() { return std::string(this->content); }
+        std::string get() { return std::string(this->content, this->length()); }
+
+        const char* data() { return this->content; }
+        size_t length() { return this->size; }
+
+        uint64_t hash() {
+            Header* header = this->header();
+            if(header->hashed != this->size) { header->hash = String::fnv(this->content, this->size); header->hashed = this->size; }
+
+            return header->hash;
+        }
 
         void set(std::string content) {
-            this->content = new char[content.length() + 1];
-            strcpy(this->content, content.c_str());
+            this->allocate(content.length(), content.length());
+            memcpy(this->content, content.data(), content.length());
+            this->seal();
         }
 
-        bool operator==(String& str) { return this->get() == str.get(); }    
-        bool operator!=(String& str) { return this->get() != str.get(); }  
+        void mark() { Heap::mark((char*)this->header()); }
 
-        bool operator<(String& str) {
-            std::string self = std::string(this->content);
-            std::string comp = std::string(str.content);
+        String intern() {
+            if(this->size != this->header()->used) this->set(this->get());
+            this->hash();
 
-            if(self.length() < comp.length()) return true;
-            if(self.length() > comp.length()) return false;
+            auto entry = String::interned[Heap::current].insert(this->content);
 
-            return self.compare(comp) < 0;
-        }   
+            this->content = *entry.first; this->header()->interned = true;
+            return *this;
+        }
 
-        bool operator>(String& str) { String self(this); if(self == str) return false; else return !(self < str); }  
+        static void sweep(Heap* heap) {
+            auto& interned = String::interned[heap];
 
-        bool operator<=(String& str) { String self(this); if(self == str) return true; else return self < str; }  
-        bool operator>=(String& str) { String self(this); if(self == str) return true; else return !(self < str); }
+            for(auto entry = interned.begin(); entry != interned.end();)
+                if(Heap::marked((char*)((Header*)*entry - 1))) entry++; else entry = interned.erase(entry);
+        }
 
-        String operator-() {
-           String result(this);
+        static void release(Heap* heap) { String::interned.erase(heap); }
 
-           std::string reversed = std::string(result.content);
-           std::reverse(reversed.begin(), reversed.end());
-           result = reversed;
+        static uint64_t fnv(const char* data, size_t length) {
+            uint64_t hash = 0xcbf29ce484222325;
+            for(size_t i = 0; i < length; i++) { hash ^= (unsigned char)data[i]; hash *= 0x100000001b3; }
 
-           return result;
+            return hash;
+        }
+
+        bool operator==(String& str) {
+            if(this->content == str.content && this->size == str.size) return true;
+            if(this->header()->interned && str.header()->interned) return false;
+            return this->length() == str.length() && this->hash() == str.hash() && memcmp(this->content, str.content, this->length()) == 0;
         }
+        bool operator!=(String& str) { return !(*this == str); }
+
+        bool operator<(String& str) {
+            if(this->length() != str.length()) return this->length() < str.length();
 
-        String operator+(String& str) {
-           std::string result = std::string(this->content) + std::string(str.content);
-           return String(result);
+            return memcmp(this->content, str.content, this->length()) < 0;
         }
 
-        static String CONCATENATE(String left, String right) {
-            std::string result = std::string(left.content) + ' ' + std::string(right.content);
-            return String(result);
+        bool operator>(String& str) { if(*this == str) return false; else return !(*this < str); }
+
+        bool operator<=(String& str) { if(*this == str) return true; else return *this < str; }
+        bool operator>=(String& str) { if(*this == str) return true; else return !(*this < str); }
+
+        String operator-() {
+           String result; result.allocate(this->length(), this->length());
+           std::reverse_copy(this->content, this->content + this->length(), result.content);
+           result.seal();
+
+           return result;
         }
 
+        String operator+(String& str) { return String::join(*this, str, ""); }
+
+        static String CONCATENATE(String left, String right) { return String::join(left, right, " "); }
+
     private:
-        char* content;
+        typedef struct {
+            size_t used, capacity;
+            uint64_t hash; size_t hashed;
+            bool interned;
+        } Header;
+
+        struct Hasher { size_t operator()(char* content) const { return ((Header*)content - 1)->hash; } };
+
+        struct Equal {
+            bool operator()(char* left, char* right) const {
+                size_t length = ((Header*)left - 1)->used;
+                return length == ((Header*)right - 1)->used && memcmp(left, right, length) == 0;
+            }
+        };
+
+        static std::unordered_map<Heap*, std::unordered_set<char*, Hasher, Equal>> interned;
+
+        char* content; size_t size;
+
+        Header* header() { return (Header*)this->content - 1; }
+
+        void allocate(size_t length, size_t capacity) {
+            this->content = (char*)((Header*)Heap::current->allocate(sizeof(Header) + capacity + 1) + 1);
+            this->size = length;
+
+            Header* header = this->header();
+            header->capacity = capacity; header->hashed = SIZE_MAX; header->interned = false;
+        }
+
+        void seal() {
+            this->header()->used = this->size;
+            this->content[this->size] = '\0';
+        }
+
+        static String join(String& left, String& right, const char* separator) {
+            size_t l = left.size, r = right.size, s = strlen(separator);
+            Header* header = left.header();
+
+            String result;
+
+            if(header->used == l && header->interned == false && l + s + r <= header->capacity) { result.content = left.content; result.size = l + s + r; }
+            else {
+                result.allocate(l + s + r, l + s + r >= STRING_BUILDER ? 2 * (l + s + r) : l + s + r);
+                memcpy(result.content, left.content, l);
+            }
+
+            memcpy(result.content + l, separator, s); memcpy(result.content + l + s, right.content, r);
+            result.seal();
+
+            return result;
+        }
 };
 
-#endif
\ No newline at end of file
+std::unordered_map<Heap*, std::unordered_set<char*, String::Hasher, String::Equal>> String::interned;
+
+#endif
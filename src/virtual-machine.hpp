@@ -2,14 +2,24 @@
 #define VIRTUAL_MACHINE_H
 
 #include <cstdint>
+#include <chrono>
+#include <atomic>
+#include <unordered_set>
 
 #include "common.hpp"
 #include "compiler.hpp"
 #include "symbol-table.hpp"
 #include "standard-library.hpp"
+#include "jit.hpp"
+#include "registers.hpp"
+#include "cache.hpp"
+#include "heap.hpp"
+#include "statistics.hpp"
+#include "profiler.hpp"
+#include "tracer.hpp"
+#include "probes.hpp"
 
 #define FRAME_MAX 1000                       
-#define STACK_MAX 1024
 
 template<class TYPE>
 class Stack {
@@ -35,7 +45,10 @@ class Stack {
 typedef struct {
     Function* function;
     uint8_t* pc; 
+    Registers::Instruction* ip;
     Value* slots;
+    Memo* memo;
+    std::string key;
 } Frame;
 
 class VM {
@@ -47,34 +60,168 @@ class VM {
         } Interpret; 
 
         VM() {
-            this->table.insert("number", number);
-            this->table.insert("string", string);
-            this->table.insert("length", length);
+            for(auto& native : natives) this->table.insert(native.name, native.native);
+            for(Frame& frame : this->frames) frame.function = nullptr;
+
+            Heap::current = &this->heap;
+        }
+
+        ~VM() { String::release(&this->heap); }
+
+        Function* compile(std::string source) { Heap::current = &this->heap; return this->parser.compile(source); }
+        Function* compile(const char* source, size_t length) { Heap::current = &this->heap; return this->parser.compile(source, length); }
+
+        bool snapshot(std::string path) {
+            for(auto& entry : this->table.entries())
+                if(this->prepare(entry.second) == false) return false;
+
+            return Cache::snapshot(path, &this->table);
         }
 
+        bool restore(std::string path) { Heap::current = &this->heap; return Cache::restore(path, &this->table); }
+
         Interpret interpret(std::string source) {
-            Function* function = this->parser.compile(source);
+            Function* function = this->compile(source);
             if(function == NULL) return INTERPRET_COMPILE_ERROR;
-            
+
+            return this->interpret(function);
+        }
+
+        Interpret interpret(Function* function) {
+            Heap::current = &this->heap;
+            this->count = 0; this->stack.topper = this->stack.stack;
+
             Frame* frame = &this->frames[this->count++];      
             frame->function = function;                          
             frame->pc = &(function->chunk->codes.front());                    
             frame->slots = this->stack.stack;
-            
-            return this->run();
+            frame->memo = nullptr;
+
+            auto start = std::chrono::steady_clock::now();
+            bool profile = Statistics::ENABLED || Heap::STATISTICS || Tracer::ENABLED;
+            Allocations::COUNTING = Statistics::ENABLED || Heap::STATISTICS || Allocations::ENABLED;
+
+            if(Statistics::ENABLED) Statistics::settle();
+            if(Tracer::ENABLED) Tracer::begin(Tracer::name("script"));
+            if(Profiler::ENABLED) { VM::sampled = this; Profiler::start(VM::sample); }
+            if(Allocations::ENABLED) { VM::current = this; Allocations::locate = VM::locate; }
+
+            this->script = function;
+
+            Interpret result;
+
+            if(Registers::ENABLED) result = profile ? this->execute<true>() : this->execute<false>();
+            else if(this->fits(frame) == false) result = this->runtime(STACK_OVERFLOW_ERROR);
+            else result = profile ? this->run<true>() : this->run<false>();
+
+            Heap::OPCODE = HEAP_OUTSIDE;
+
+            if(Statistics::ENABLED) { Statistics::settle(); Statistics::time(Statistics::RUN, start); }
+            if(Tracer::ENABLED) Tracer::unwind();
+            if(Profiler::ENABLED) { Profiler::stop(); VM::sampled = nullptr; this->profile(function); }
+            if(Allocations::ENABLED) { VM::current = nullptr; this->census("at the end of the run"); }
+
+            return result;
+        }
+
+        bool census(std::string label) {
+            std::vector<Allocations::Site> chunks;
+
+            for(auto& entry : this->functions(this->script)) {
+                Chunk* chunk = entry.first;
+
+                size_t bytes = sizeof(Chunk) + chunk->codes.capacity() + chunk->values.capacity() * sizeof(Value) + chunk->lines.runs.capacity() * sizeof(Lines::Run);
+                if(chunk->registers != nullptr) bytes += sizeof(Registers) + chunk->registers->codes.capacity() * sizeof(Registers::Instruction) + chunk->registers->lines.runs.capacity() * sizeof(Lines::Run);
+
+                chunks.push_back({ Allocations::CHUNK, entry.second, chunk->lines.size() > 0 ? chunk->lines[0] : 0, 1, bytes, 1, bytes });
+            }
+
+            return Allocations::dump(label, chunks);
         }
 
     private:
         Frame frames[FRAME_MAX]; int count = 0;
         Parser parser; Stack<Value> stack;
-        Table table;
+        Table table; Heap heap;
+
+        Function* script = nullptr;
+
+        static VM* current;
+
+        static void locate(std::string* function, int* line) {
+            VM* vm = VM::current;
+            if(vm == nullptr || vm->count == 0) return;
+
+            Frame* frame = &vm->frames[vm->count - 1];
+
+            *function = frame->function->name.empty() ? "script" : frame->function->name;
+            *line = vm->line(frame);
+        }
+
+        int line(Frame* frame) {
+            Chunk* chunk = frame->function->chunk;
+
+            if(Registers::ENABLED) {
+                if(chunk->registers == nullptr) return 0;
+
+                long offset = frame->ip - chunk->registers->codes.data();
+                return chunk->registers->lines[offset > 0 ? offset - 1 : 0];
+            }
+
+            long offset = frame->pc - &(chunk->codes.front());
+            return chunk->lines[offset > 0 ? offset - 1 : 0];
+        }
+
+        static VM* sampled;
+
+        static void sample(int) {
+            VM* vm = VM::sampled;
+            if(vm == nullptr) return;
+
+            int count = vm->count;
+
+            Profiler::Site* sites = Profiler::reserve(count);
+            if(sites == nullptr) return;
 
+            for(int i = 0; i < count; i++) {
+                Frame* frame = &vm->frames[i];
+                sites[i] = { frame->function != nullptr ? frame->function->chunk : nullptr, Registers::ENABLED ? (uintptr_t)frame->ip : (uintptr_t)frame->pc };
+            }
+        }
+
+        void profile(Function* script) { Profiler::resolve(this->functions(script)); }
+
+        std::unordered_map<Chunk*, std::string> functions(Function* script) {
+            std::unordered_map<Chunk*, std::string> names;
+            if(script == nullptr) return names;
+
+            std::vector<std::pair<std::string, Value>> entries = this->table.entries();
+            std::vector<Function*> functions = { script };
+
+            for(auto& entry : entries)
+                if(entry.second.index() == VAL_FUNCTION) functions.push_back(&entry.second.value.function);
+
+            while(functions.empty() == false) {
+                Function* function = functions.back(); functions.pop_back();
+                if(names.count(function->chunk)) continue;
+
+                names[function->chunk] = function->name.empty() ? "script" : function->name;
+
+                for(Value& value : function->chunk->values)
+                    if(value.index() == VAL_FUNCTION) functions.push_back(&value.value.function);
+            }
+
+            return names;
+        }
+
+        template<bool PROFILE>
         Interpret run() {   
             Frame* frame = &this->frames[this->count - 1];
 
             #define READ_BYTE() (*frame->pc++)
             #define READ_SHORT() (frame->pc += 2, (uint16_t)((frame->pc[-2] << 8) | frame->pc[-1]))
-            #define READ_CONSTANT() (frame->function->chunk->values[READ_BYTE()])
+            #define READ_LONG() (frame->pc += 3, (uint32_t)((frame->pc[-3] << 16) | (frame->pc[-2] << 8) | frame->pc[-1]))
+            #define READ_CONSTANT() (frame->function->chunk->values[operand])
 
             #define OPERATOR(type, tag) \
                     type right = this->stack.pop().value.tag; \
@@ -91,11 +238,20 @@ class VM {
                     this->stack.push(result); \
                 } while(false)
 
+            #define HOT(counter, threshold) do { \
+                    Chunk* chunk = frame->function->chunk; \
+                    if(chunk->jit == nullptr && ++chunk->counter == threshold) chunk->jit = JIT::compile(&chunk->codes, frame->function->name, VM::helpers()); \
+                    if(chunk->jit != nullptr) frame->pc = chunk->jit->enter(this, frame->pc); \
+                } while(false)
+
             while(true) {       
-                uint8_t instruction = READ_BYTE();
+                uint8_t instruction = READ_BYTE(); uint32_t operand;
+                if constexpr(PROFILE) { Heap::OPCODE = instruction; if(Statistics::ENABLED) Statistics::dispatch(instruction); }
 
                 switch(instruction) {
-                    case OP_CONSTANT: {
+                    case OP_CONSTANT_LONG: operand = READ_LONG(); goto CONSTANT;
+                    case OP_CONSTANT: operand = READ_BYTE();
+                    CONSTANT: {
                         Value constant = READ_CONSTANT();
                         this->stack.push(constant);                     
                         break;
@@ -208,20 +364,7 @@ class VM {
                         return this->runtime(OPERANDS_ERROR);
                     }
 
-                    case OP_PRINT: {  
-                        switch(this->stack.top().index()) {
-                            case VAL_NUMBER: { Number number = this->stack.pop().value.number; printf("%s\n", number.get().c_str()); break; }
-                            case VAL_BOOLEAN: { Boolean boolean = this->stack.pop().value.boolean; printf("%s\n", boolean.get().c_str()); break; }
-                            case VAL_STRING: { String string = this->stack.pop().value.string; printf("%s\n", string.get().c_str()); break; }
-
-                            case VAL_FUNCTION: { Function function = this->stack.pop().value.function; printf("<Function object: `%s`>\n", function.name.c_str()); break; }
-                            case VAL_NATIVE: {  this->stack.pop(); printf("<Standard library function>\n"); break;}
-
-                            case VAL_VOID: { this->stack.pop(); printf("%s\n", Void::VOID().get().c_str()); break; }
-                        }
-
-                        break; 
-                    }
+                    case OP_PRINT: VM::print(this->stack.pop()); break;
 
                     case OP_INPUT: {
                         std::string data; std::cin >> data;
@@ -230,87 +373,176 @@ class VM {
                         break;
                     }
 
-                    case OP_DECLARATION: {
-                        std::string identifier = READ_CONSTANT().value.string.get();
-                        if(this->table.insert(identifier, this->stack.pop()) == false) return this->runtime(DECLARATION_ERROR);
+                    case OP_DECLARATION_LONG: operand = READ_LONG(); goto DECLARATION;
+                    case OP_DECLARATION: operand = READ_BYTE();
+                    DECLARATION: {
+                        if(this->table.insert(READ_CONSTANT().value.string, this->stack.pop()) == false) return this->runtime(DECLARATION_ERROR);
                         break;
                     }
 
-                    case OP_VARIABLE: {
-                        std::string identifier = READ_CONSTANT().value.string.get();
-                        Value value = this->table.get(identifier);
+                    case OP_VARIABLE_LONG: operand = READ_LONG(); goto VARIABLE;
+                    case OP_VARIABLE: operand = READ_BYTE();
+                    VARIABLE: {
+                        Value value = this->table.get(READ_CONSTANT().value.string);
                         this->stack.push(value);
                         break;
                     }
 
-                    case OP_ASSIGNMENT_VARIABLE: {
-                        std::string identifier = READ_CONSTANT().value.string.get();
-                        if(this->table.set(identifier, this->stack.top()) == false) return this->runtime(ASSIGNMENT_ERROR);
+                    case OP_ASSIGNMENT_VARIABLE_LONG: operand = READ_LONG(); goto ASSIGNMENT_VARIABLE;
+                    case OP_ASSIGNMENT_VARIABLE: operand = READ_BYTE();
+                    ASSIGNMENT_VARIABLE: {
+                        if(this->table.set(READ_CONSTANT().value.string, this->stack.top()) == false) return this->runtime(ASSIGNMENT_ERROR);
                         break;
                     }
 
-                    case OP_LOCAL: {
-                        uint8_t slot = READ_BYTE();    
-                        this->stack.push(frame->slots[slot]);
+                    case OP_LOCAL_LONG: operand = READ_SHORT(); goto LOCAL;
+                    case OP_LOCAL: operand = READ_BYTE();
+                    LOCAL: {
+                        this->stack.push(frame->slots[operand]);
                         break;
                     }
 
-                    case OP_ASSIGNMENT_LOCAL: {
-                        uint8_t slot = READ_BYTE();
-                        frame->slots[slot] = this->stack.top();  
+                    case OP_ASSIGNMENT_LOCAL_LONG: operand = READ_SHORT(); goto ASSIGNMENT_LOCAL;
+                    case OP_ASSIGNMENT_LOCAL: operand = READ_BYTE();
+                    ASSIGNMENT_LOCAL: {
+                        frame->slots[operand] = this->stack.top();  
                         break;
                     }
 
-                    case OP_CONDITION: {
-                        uint16_t offset = READ_SHORT();
-
+                    case OP_CONDITION_LONG: operand = READ_LONG(); goto CONDITION;
+                    case OP_CONDITION: operand = READ_SHORT();
+                    CONDITION: {
                         if(this->stack.top().index() == VAL_BOOLEAN) {
                             Boolean condition = this->stack.top().value.boolean;
-                            if(!condition.boolean) frame->pc += offset;
+                            if(!condition.boolean) frame->pc += operand;
                             break;
                         }
 
                         return this->runtime(CONDITION_ERROR);
                     }
 
-                    case OP_JUMP: {
-                        uint16_t offset = READ_SHORT();
-                        frame->pc += offset;               
+                    case OP_JUMP_LONG: operand = READ_LONG(); goto JUMP;
+                    case OP_JUMP: operand = READ_SHORT();
+                    JUMP: {
+                        frame->pc += operand;               
                         break;
                     }
 
-                    case OP_LOOP: {
-                        uint16_t offset = READ_SHORT();
-                        frame->pc -= offset;                                       
+                    case OP_LOOP_LONG: operand = READ_LONG(); goto LOOP;
+                    case OP_LOOP: operand = READ_SHORT();
+                    LOOP: {
+                        frame->pc -= operand;                                       
+                        if(this->heap.pending()) this->collect();
+                        if(JIT::ENABLED) HOT(edges, JIT::EDGES);
+                        break;
+                    }
+
+                    case OP_RANGE_LONG: case OP_RANGE: {
+                        Value* counter = &frame->slots[READ_SHORT()];
+                        operand = instruction == OP_RANGE ? READ_SHORT() : READ_LONG();
+
+                        int64_t start, end;
+
+                        if(counter[0].index() != VAL_NUMBER || counter[0].value.number.integral(&start) == false) return this->runtime(RANGE_ERROR);
+                        if(counter[1].index() != VAL_NUMBER || counter[1].value.number.integral(&end) == false) return this->runtime(RANGE_ERROR);
+
+                        counter[0] = Value(start); counter[1] = Value(end);
+
+                        if(start >= end) frame->pc += operand;
+                        break;
+                    }
+
+                    case OP_RANGE_LOOP_LONG: case OP_RANGE_LOOP: {
+                        Value* counter = &frame->slots[READ_SHORT()];
+                        operand = instruction == OP_RANGE_LOOP ? READ_SHORT() : READ_LONG();
+
+                        if(++counter[0].value.integer < counter[1].value.integer) { 
+                            frame->pc -= operand; 
+                            if(this->heap.pending()) this->collect();
+                            if(JIT::ENABLED) HOT(edges, JIT::EDGES); 
+                        }
+
+                        break;
+                    }
+
+                    case OP_COUNTER: {
+                        Value* counter = &frame->slots[READ_SHORT()];
+                        this->stack.push(Number::INTEGER(counter->value.integer));
                         break;
                     }
 
                     case OP_CALL: {
                         if(this->count == FRAME_MAX) return this->runtime(STACK_OVERFLOW_ERROR);
+                        if(this->heap.pending()) this->collect();
 
                         int arguments = READ_BYTE();
                         
                         Value function = this->stack.peek(arguments);
 
+                        if(this->prepare(function) == false) return INTERPRET_COMPILE_ERROR;
+                        if(frame->function->memo != nullptr && pure(&function) == false) return this->runtime(PURITY_ERROR);
+
+                        if constexpr(PROFILE) this->begin(function);
                         if(this->call(function, arguments) == false) return INTERPRET_RUNTIME_ERROR;
+                        if constexpr(PROFILE) this->end(frame);
 
                         frame = &this->frames[this->count - 1];
+
+                        if(JIT::ENABLED && frame->pc == &(frame->function->chunk->codes.front())) HOT(calls, JIT::CALLS);
                         
                         break;
                     }
 
+                    case OP_TAIL_CALL: {
+                        if(this->heap.pending()) this->collect();
+
+                        int arguments = READ_BYTE();
+
+                        Value function = this->stack.peek(arguments);
+
+                        if(this->prepare(function) == false) return INTERPRET_COMPILE_ERROR;
+                        if(frame->function->memo != nullptr && pure(&function) == false) return this->runtime(PURITY_ERROR);
+
+                        if(this->count == 1 || function.index() != VAL_FUNCTION || frame->memo != nullptr || function.value.function.memo != nullptr) {
+                            if(this->count == FRAME_MAX) return this->runtime(STACK_OVERFLOW_ERROR);
+
+                            if constexpr(PROFILE) this->begin(function);
+                            if(this->call(function, arguments) == false) return INTERPRET_RUNTIME_ERROR;
+                            if constexpr(PROFILE) this->end(frame);
+
+                            frame = &this->frames[this->count - 1];
+
+                            if(JIT::ENABLED && frame->pc == &(frame->function->chunk->codes.front())) HOT(calls, JIT::CALLS);
+
+                            break;
+                        }
+
+                        if constexpr(PROFILE) { if(Tracer::ENABLED) Tracer::end(); this->begin(function); }
+                        if(this->tail(function, arguments) == false) return INTERPRET_RUNTIME_ERROR;
+
+                        if(JIT::ENABLED) HOT(calls, JIT::CALLS);
+
+                        break;
+                    }
+
                     case OP_RETURN: {        
                         if(this->count == 1) return this->runtime(RETURN_ERROR);
 
                         Value returned = this->stack.pop();
+
+                        if(frame->memo != nullptr) frame->memo->insert(frame->key, returned);
+                        PROBE1(function__return, frame->function->name.c_str());
                         
                         this->count--;                             
+                        if constexpr(PROFILE) { if(Tracer::ENABLED) Tracer::end(); }
 
-                        this->stack.topper = frame->slots;        
+                        this->stack.topper = frame->slots - 1;        
                         this->stack.push(returned);                         
 
                         frame = &this->frames[this->count - 1];
 
+                        if(JIT::ENABLED && frame->function->chunk->jit != nullptr) frame->pc = frame->function->chunk->jit->enter(this, frame->pc);
+
                         break;
                     }
 
@@ -324,12 +556,391 @@ class VM {
 
             #undef READ_BYTE
             #undef READ_SHORT
+            #undef READ_LONG
             #undef READ_CONSTANT
             #undef OPERATOR
             #undef BINARY_OP
             #undef COMPARISON_OP    
+            #undef HOT
         }   
 
+        template<bool PROFILE>
+        Interpret execute() {
+            Frame* frame = &this->frames[this->count - 1];
+
+            Registers* code = this->translate(frame->function);
+            frame->ip = code->codes.data();
+
+            Value* r = frame->slots; std::vector<Value>* values = &frame->function->chunk->values;
+
+            #define RK(operand) (((operand) & CONSTANT_FLAG) ? (*values)[(operand) & ~CONSTANT_FLAG] : r[operand])
+            #define RELOAD() do { \
+                    frame = &this->frames[this->count - 1]; \
+                    code = frame->function->chunk->registers; \
+                    r = frame->slots; values = &frame->function->chunk->values; \
+                } while(false)
+
+            #define NUMBERS(left, right) (left.index() == VAL_NUMBER && right.index() == VAL_NUMBER)
+            #define STRINGS(left, right) (left.index() == VAL_STRING && right.index() == VAL_STRING)
+            #define BOOLEANS(left, right) (left.index() == VAL_BOOLEAN && right.index() == VAL_BOOLEAN)
+
+            #define ARITHMETIC_OP(operator) do { \
+                    if(NUMBERS(left, right) == false) return this->runtime(OPERANDS_ERROR); \
+                    r[instruction->a] = left.value.number operator right.value.number; \
+                } while(false)
+
+            #define COMPARISON_OP(operator) do { \
+                    Boolean result; \
+                    if(NUMBERS(left, right)) result = left.value.number operator right.value.number; \
+                    else if(STRINGS(left, right)) result = left.value.string operator right.value.string; \
+                    else return this->runtime(OPERANDS_ERROR); \
+                    r[instruction->a] = result; \
+                } while(false)
+
+            #define EQUALITY_OP(operator, otherwise) do { \
+                    Boolean result = otherwise; \
+                    if(NUMBERS(left, right)) result = left.value.number operator right.value.number; \
+                    else if(BOOLEANS(left, right)) result = left.value.boolean operator right.value.boolean; \
+                    else if(STRINGS(left, right)) result = left.value.string operator right.value.string; \
+                    else if(left.index() == VAL_VOID && right.index() == VAL_VOID) result = left.value.null operator right.value.null; \
+                    r[instruction->a] = result; \
+                } while(false)
+
+            while(true) {
+                Registers::Instruction* instruction = frame->ip++;
+                if constexpr(PROFILE) { Heap::OPCODE = instruction->code; if(Statistics::ENABLED) Statistics::dispatch(instruction->code); }
+
+                switch(instruction->code) {
+                    case OP_TRUE: r[instruction->a] = Boolean::TRUE(); break; case OP_FALSE: r[instruction->a] = Boolean::FALSE(); break;
+
+                    case OP_VOID: r[instruction->a] = Void::VOID(); break;
+
+                    case OP_PLUS: {
+                        Value& value = RK(instruction->b);
+                        if(value.index() != VAL_NUMBER && value.index() != VAL_STRING) return this->runtime(OPERANDS_ERROR); else break;
+                    }
+
+                    case OP_MINUS: {
+                        Value& value = RK(instruction->b);
+
+                        if(value.index() == VAL_NUMBER) { Number number = value.value.number; r[instruction->a] = -number; break; }
+                        if(value.index() == VAL_STRING) { String string = value.value.string; r[instruction->a] = -string; break; }
+
+                        return this->runtime(OPERANDS_ERROR);
+                    }
+
+                    case OP_NOT: {
+                        Value& value = RK(instruction->b);
+
+                        if(value.index() != VAL_BOOLEAN) return this->runtime(OPERANDS_ERROR);
+                        Boolean boolean = value.value.boolean; r[instruction->a] = !boolean; break;
+                    }
+
+                    case OP_ADD: {
+                        Value& left = RK(instruction->b); Value& right = RK(instruction->c);
+
+                        if(NUMBERS(left, right)) { r[instruction->a] = left.value.number + right.value.number; break; }
+                        if(STRINGS(left, right)) { r[instruction->a] = left.value.string + right.value.string; break; }
+
+                        return this->runtime(OPERANDS_ERROR);
+                    }
+
+                    case OP_SUBTRACT: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); ARITHMETIC_OP(-); break; }
+                    case OP_MULTIPLY: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); ARITHMETIC_OP(*); break; }
+                    case OP_DIVIDE: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); ARITHMETIC_OP(/); break; }
+                    case OP_MOD: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); ARITHMETIC_OP(%); break; }
+
+                    case OP_CONCATENATE: {
+                        Value& left = RK(instruction->b); Value& right = RK(instruction->c);
+
+                        if(STRINGS(left, right) == false) return this->runtime(OPERANDS_ERROR);
+                        r[instruction->a] = String::CONCATENATE(left.value.string, right.value.string); break;
+                    }
+
+                    case OP_AND: case OP_OR: {
+                        Value& left = RK(instruction->b); Value& right = RK(instruction->c);
+
+                        if(BOOLEANS(left, right) == false) return this->runtime(OPERANDS_ERROR);
+
+                        Boolean a = left.value.boolean, b = right.value.boolean;
+                        r[instruction->a] = instruction->code == OP_AND ? a && b : a || b; break;
+                    }
+
+                    case OP_EQUALS: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); EQUALITY_OP(==, Boolean::FALSE()); break; }
+                    case OP_NOT_EQUALS: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); EQUALITY_OP(!=, Boolean::TRUE()); break; }
+
+                    case OP_GREATER: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); COMPARISON_OP(>); break; }
+                    case OP_LESS: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); COMPARISON_OP(<); break; }
+                    case OP_GREATER_EQUALS: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); COMPARISON_OP(>=); break; }
+                    case OP_LESS_EQUALS: { Value& left = RK(instruction->b); Value& right = RK(instruction->c); COMPARISON_OP(<=); break; }
+
+                    case OP_PRINT: VM::print(RK(instruction->b)); break;
+
+                    case OP_INPUT: {
+                        std::string data; std::cin >> data;
+                        r[instruction->a] = String(data);
+                        break;
+                    }
+
+                    case OP_DECLARATION: {
+                        if(this->table.insert((*values)[instruction->a].value.string, RK(instruction->b)) == false) return this->runtime(DECLARATION_ERROR);
+                        break;
+                    }
+
+                    case OP_VARIABLE: {
+                        r[instruction->a] = this->table.get((*values)[instruction->b].value.string);
+                        break;
+                    }
+
+                    case OP_ASSIGNMENT_VARIABLE: {
+                        if(this->table.set((*values)[instruction->a].value.string, RK(instruction->b)) == false) return this->runtime(ASSIGNMENT_ERROR);
+                        break;
+                    }
+
+                    case OP_ASSIGNMENT_LOCAL: r[instruction->a] = RK(instruction->b); break;
+
+                    case OP_CONDITION: {
+                        if(r[instruction->b].index() != VAL_BOOLEAN) return this->runtime(CONDITION_ERROR);
+                        if(!r[instruction->b].value.boolean.boolean) frame->ip = code->codes.data() + instruction->a;
+                        break;
+                    }
+
+                    case OP_JUMP:
+                        frame->ip = code->codes.data() + instruction->a;
+                        if(this->heap.pending()) this->collect();
+                        break;
+
+                    case OP_RANGE: {
+                        Value* counter = &r[instruction->b];
+
+                        int64_t start, end;
+
+                        if(counter[0].index() != VAL_NUMBER || counter[0].value.number.integral(&start) == false) return this->runtime(RANGE_ERROR);
+                        if(counter[1].index() != VAL_NUMBER || counter[1].value.number.integral(&end) == false) return this->runtime(RANGE_ERROR);
+
+                        counter[0] = Value(start); counter[1] = Value(end);
+
+                        if(start >= end) frame->ip = code->codes.data() + instruction->a;
+                        break;
+                    }
+
+                    case OP_RANGE_LOOP: {
+                        Value* counter = &r[instruction->b];
+                        if(++counter[0].value.integer < counter[1].value.integer) frame->ip = code->codes.data() + instruction->a;
+                        if(this->heap.pending()) this->collect();
+                        break;
+                    }
+
+                    case OP_COUNTER: r[instruction->a] = Number::INTEGER(r[instruction->b].value.integer); break;
+
+                    case OP_CALL: {
+                        if(this->count == FRAME_MAX) return this->runtime(STACK_OVERFLOW_ERROR);
+                        if(this->heap.pending()) this->collect();
+
+                        Value* callee = &r[instruction->a];
+
+                        if(this->prepare(*callee) == false) return INTERPRET_COMPILE_ERROR;
+                        if(frame->function->memo != nullptr && pure(callee) == false) return this->runtime(PURITY_ERROR);
+
+                        if constexpr(PROFILE) this->begin(*callee);
+                        if(this->invoke(callee, instruction->b) == false) return INTERPRET_RUNTIME_ERROR;
+                        if constexpr(PROFILE) this->end(frame);
+
+                        RELOAD();
+                        break;
+                    }
+
+                    case OP_TAIL_CALL: {
+                        if(this->heap.pending()) this->collect();
+
+                        Value* callee = &r[instruction->a]; int arguments = instruction->b;
+
+                        if(this->prepare(*callee) == false) return INTERPRET_COMPILE_ERROR;
+                        if(frame->function->memo != nullptr && pure(callee) == false) return this->runtime(PURITY_ERROR);
+
+                        if(this->count == 1 || callee->index() != VAL_FUNCTION || frame->memo != nullptr || callee->value.function.memo != nullptr) {
+                            if(this->count == FRAME_MAX) return this->runtime(STACK_OVERFLOW_ERROR);
+
+                            if constexpr(PROFILE) this->begin(*callee);
+                            if(this->invoke(callee, arguments) == false) return INTERPRET_RUNTIME_ERROR;
+                            if constexpr(PROFILE) this->end(frame);
+
+                            RELOAD();
+                            break;
+                        }
+
+                        if(callee->value.function.parameters != arguments) return this->runtime(ARGUMENTS_ERROR);
+                        if constexpr(PROFILE) { if(Tracer::ENABLED) Tracer::end(); this->begin(*callee); }
+
+                        PROBE1(function__return, frame->function->name.c_str());
+
+                        r[-1] = *callee;
+                        for(int i = 0; i < arguments; i++) r[i] = callee[i + 1];
+
+                        frame->function = &r[-1].value.function;
+                        if(this->enter(frame) == false) return this->runtime(STACK_OVERFLOW_ERROR);
+
+                        PROBE2(function__entry, frame->function->name.c_str(), arguments);
+
+                        RELOAD();
+                        break;
+                    }
+
+                    case OP_RETURN: {
+                        if(this->count == 1) return this->runtime(RETURN_ERROR);
+
+                        Value returned = RK(instruction->b);
+
+                        if(frame->memo != nullptr) frame->memo->insert(frame->key, returned);
+                        PROBE1(function__return, frame->function->name.c_str());
+
+                        this->count--;
+                        if constexpr(PROFILE) { if(Tracer::ENABLED) Tracer::end(); }
+
+                        r[-1] = returned;
+
+                        RELOAD();
+                        break;
+                    }
+
+                    case OP_EXIT: return INTERPRET_OK;
+                }
+            }
+
+            #undef RK
+            #undef RELOAD
+            #undef NUMBERS
+            #undef STRINGS
+            #undef BOOLEANS
+            #undef ARITHMETIC_OP
+            #undef COMPARISON_OP
+            #undef EQUALITY_OP
+        }
+
+        void begin(Value& callee) {
+            if(Statistics::ENABLED) Statistics::call(callee);
+            if(Tracer::ENABLED) Tracer::begin(callee);
+        }
+
+        void end(Frame* caller) { if(Tracer::ENABLED && caller == &this->frames[this->count - 1]) Tracer::end(); }
+
+        bool invoke(Value* callee, int arguments) {
+            switch(callee->index()) {
+                case VAL_FUNCTION: {
+                    Function* function = &callee->value.function;
+
+                    if(function->parameters != arguments) { this->runtime(ARGUMENTS_ERROR); return false; }
+
+                    std::string key; Memo* memo = nullptr;
+
+                    if(function->memo != nullptr && Memo::key(callee + 1, arguments, &key)) {
+                        if(function->memo->find(key, callee)) return true;
+                        memo = function->memo;
+                    }
+
+                    Frame* frame = &this->frames[this->count];
+                    frame->slots = callee + 1;
+                    frame->function = function;
+                    frame->memo = memo; frame->key = key;
+
+                    if(this->enter(frame) == false) { this->runtime(STACK_OVERFLOW_ERROR); return false; }
+
+                    std::atomic_signal_fence(std::memory_order_release); this->count++;
+
+                    PROBE2(function__entry, function->name.c_str(), arguments);
+
+                    return true;
+                }
+
+                case VAL_NATIVE:
+                    PROBE2(native__call, (void*)callee->value.native, arguments);
+                    *callee = callee->value.native(callee + 1, arguments); return true;
+
+                case VAL_INTEGER: this->runtime(FUNCTION_ERROR); return false;
+            }
+
+            this->runtime(FUNCTION_ERROR); return false;
+        }
+
+        void collect() {
+            auto start = std::chrono::steady_clock::now();
+            std::unordered_set<Chunk*> chunks;
+
+            Value* top = this->stack.topper;
+
+            if(Registers::ENABLED) {
+                top = this->stack.stack;
+
+                for(int i = 0; i < this->count; i++) {
+                    Value* end = this->frames[i].slots + this->frames[i].function->chunk->registers->count;
+                    if(end > top) top = end;
+                }
+            }
+
+            for(Value* value = this->stack.stack; value < top; value++) this->trace(*value, &chunks);
+            for(Value* value = top; value < this->stack.stack + STACK_MAX; value++) if(value->index() == VAL_STRING) *value = Void::VOID();
+
+            for(int i = 0; i < this->count; i++) this->trace(this->frames[i].function, &chunks);
+            for(auto& entry : this->table.entries()) this->trace(entry.second, &chunks);
+
+            String::sweep(&this->heap);
+            this->heap.sweep(start);
+
+            if(Allocations::ENABLED && Allocations::due()) this->census("after a collection");
+        }
+
+        void trace(Value& value, std::unordered_set<Chunk*>* chunks) {
+            if(value.index() == VAL_STRING) value.value.string.mark();
+            if(value.index() == VAL_FUNCTION) this->trace(&value.value.function, chunks);
+        }
+
+        void trace(Function* function, std::unordered_set<Chunk*>* chunks) {
+            if(chunks->insert(function->chunk).second == false) return;
+
+            for(Value& value : function->chunk->values) this->trace(value, chunks);
+            if(function->memo != nullptr) function->memo->visit([&](Value& value) { this->trace(value, chunks); });
+        }
+
+        Registers* translate(Function* function) {
+            Chunk* chunk = function->chunk;
+            if(chunk->registers == nullptr) chunk->registers = Registers::compile(function);
+            return chunk->registers;
+        }
+
+        bool enter(Frame* frame) {
+            Registers* code = this->translate(frame->function);
+            if(frame->slots + code->count > this->stack.stack + STACK_MAX) return false;
+
+            frame->ip = code->codes.data();
+            return true;
+        }
+
+        bool fits(Frame* frame) {
+            Chunk* chunk = frame->function->chunk;
+
+            if(chunk->depth == -1) {
+                std::vector<int> depths; std::vector<bool> labels;
+                chunk->depth = analyze(frame->function, &depths, &labels);
+            }
+
+            return frame->slots + chunk->depth <= this->stack.stack + STACK_MAX;
+        }
+
+        static void print(Value value) {
+            switch(value.index()) {
+                case VAL_NUMBER: printf("%s\n", value.value.number.get().c_str()); break;
+                case VAL_BOOLEAN: printf("%s\n", value.value.boolean.get().c_str()); break;
+                case VAL_STRING: printf("%.*s\n", (int)value.value.string.length(), value.value.string.data()); break;
+
+                case VAL_FUNCTION: printf("<Function object: `%s`>\n", value.value.function.name.c_str()); break;
+                case VAL_NATIVE: printf("<Standard library function>\n"); break;
+
+                case VAL_VOID: printf("%s\n", Void::VOID().get().c_str()); break;
+
+                case VAL_INTEGER: printf("%s\n", Number::INTEGER(value.value.integer).get().c_str()); break;
+            }
+        }
+
         bool call(Value constant, int arguments) {
             switch(constant.index()) {
                 case VAL_FUNCTION: {
@@ -337,18 +948,39 @@ class VM {
 
                     if(function->parameters != arguments) { this->runtime(ARGUMENTS_ERROR); return false; } 
 
-                    Frame* frame = &this->frames[this->count++];      
-                    frame->function = function;       
-                    frame->pc = &(function->chunk->codes.front());                    
-                    frame->slots = this->stack.topper - arguments - 1;
+                    std::string key; Memo* memo = nullptr;
+
+                    if(function->memo != nullptr && Memo::key(this->stack.topper - arguments, arguments, &key)) {
+                        Value result;
+
+                        if(function->memo->find(key, &result)) {
+                            this->stack.topper -= arguments + 1;
+                            this->stack.push(result);
+
+                            return true;
+                        }
+
+                        memo = function->memo;
+                    }
+
+                    Frame* frame = &this->frames[this->count];      
+                    frame->slots = this->stack.topper - arguments;
+                    frame->function = &frame->slots[-1].value.function;       
+                    frame->pc = &(frame->function->chunk->codes.front());                    
+                    frame->memo = memo; frame->key = key;
+
+                    if(this->fits(frame) == false) { this->runtime(STACK_OVERFLOW_ERROR); return false; }
 
-                    this->stack.remove(arguments);
+                    std::atomic_signal_fence(std::memory_order_release); this->count++;
+
+                    PROBE2(function__entry, frame->function->name.c_str(), arguments);
 
                     return true;
                 }
 
                 case VAL_NATIVE: {
                     Native native = constant.value.native;
+                    PROBE2(native__call, (void*)native, arguments);
 
                     Value result = native(this->stack.topper - arguments, arguments);
                     this->stack.topper -= arguments + 1;                            
@@ -356,19 +988,149 @@ class VM {
 
                     return true;
                 }
+
+                case VAL_INTEGER: this->runtime(FUNCTION_ERROR); return false;
             }
 
             this->runtime(FUNCTION_ERROR); return false;
         }
 
+        static JIT::Helper* helpers() {
+            static JIT::Helper table[UINT8_MAX + 1] = { nullptr };
+            if(table[OP_CONSTANT] != nullptr) return table;
+
+            table[OP_CONSTANT] = table[OP_CONSTANT_LONG] = VM::jit_constant;
+            table[OP_TRUE] = VM::jit_true; table[OP_FALSE] = VM::jit_false; table[OP_VOID] = VM::jit_void;
+
+            table[OP_ADD] = VM::jit_arithmetic<OP_ADD>; table[OP_SUBTRACT] = VM::jit_arithmetic<OP_SUBTRACT>;
+            table[OP_MULTIPLY] = VM::jit_arithmetic<OP_MULTIPLY>; table[OP_DIVIDE] = VM::jit_arithmetic<OP_DIVIDE>;
+            table[OP_MOD] = VM::jit_arithmetic<OP_MOD>;
+
+            table[OP_EQUALS] = VM::jit_comparison<OP_EQUALS>; table[OP_NOT_EQUALS] = VM::jit_comparison<OP_NOT_EQUALS>;
+            table[OP_GREATER] = VM::jit_comparison<OP_GREATER>; table[OP_GREATER_EQUALS] = VM::jit_comparison<OP_GREATER_EQUALS>;
+            table[OP_LESS] = VM::jit_comparison<OP_LESS>; table[OP_LESS_EQUALS] = VM::jit_comparison<OP_LESS_EQUALS>;
+
+            table[OP_VARIABLE] = table[OP_VARIABLE_LONG] = VM::jit_variable;
+            table[OP_LOCAL] = table[OP_LOCAL_LONG] = VM::jit_local;
+            table[OP_ASSIGNMENT_LOCAL] = table[OP_ASSIGNMENT_LOCAL_LONG] = VM::jit_assignment_local;
+            table[OP_COUNTER] = VM::jit_counter;
+
+            table[OP_CONDITION] = table[OP_CONDITION_LONG] = VM::jit_condition;
+            table[OP_RANGE_LOOP] = table[OP_RANGE_LOOP_LONG] = VM::jit_range_loop;
+
+            table[OP_POP] = VM::jit_pop; table[OP_EMPTY] = VM::jit_empty;
+
+            return table;
+        }
+
+        static int jit_constant(VM* vm, uint32_t operand) { vm->stack.push(vm->frames[vm->count - 1].function->chunk->values[operand]); return 0; }
+
+        static int jit_true(VM* vm, uint32_t /*operand*/) { vm->stack.push(Boolean::TRUE()); return 0; }
+        static int jit_false(VM* vm, uint32_t /*operand*/) { vm->stack.push(Boolean::FALSE()); return 0; }
+        static int jit_void(VM* vm, uint32_t /*operand*/) { vm->stack.push(Void::VOID()); return 0; }
+
+        template<uint8_t INSTRUCTION>
+        static int jit_arithmetic(VM* vm, uint32_t /*operand*/) {
+            if(vm->stack.top().index() != VAL_NUMBER || vm->stack.peek(1).index() != VAL_NUMBER) return 1;
+
+            Number right = vm->stack.pop().value.number;
+            Number left = vm->stack.pop().value.number;
+
+            switch(INSTRUCTION) {
+                case OP_ADD: vm->stack.push(left + right); break;
+                case OP_SUBTRACT: vm->stack.push(left - right); break;
+                case OP_MULTIPLY: vm->stack.push(left * right); break;
+                case OP_DIVIDE: vm->stack.push(left / right); break;
+                case OP_MOD: vm->stack.push(left % right); break;
+            }
+
+            return 0;
+        }
+
+        template<uint8_t INSTRUCTION>
+        static int jit_comparison(VM* vm, uint32_t /*operand*/) {
+            if(vm->stack.top().index() != VAL_NUMBER || vm->stack.peek(1).index() != VAL_NUMBER) return 1;
+
+            Number right = vm->stack.pop().value.number;
+            Number left = vm->stack.pop().value.number;
+
+            switch(INSTRUCTION) {
+                case OP_EQUALS: vm->stack.push(Boolean(left == right)); break;
+                case OP_NOT_EQUALS: vm->stack.push(Boolean(left != right)); break;
+                case OP_GREATER: vm->stack.push(Boolean(left > right)); break;
+                case OP_GREATER_EQUALS: vm->stack.push(Boolean(left >= right)); break;
+                case OP_LESS: vm->stack.push(Boolean(left < right)); break;
+                case OP_LESS_EQUALS: vm->stack.push(Boolean(left <= right)); break;
+            }
+
+            return 0;
+        }
+
+        static int jit_variable(VM* vm, uint32_t operand) {
+            vm->stack.push(vm->table.get(vm->frames[vm->count - 1].function->chunk->values[operand].value.string));
+            return 0;
+        }
+
+        static int jit_local(VM* vm, uint32_t operand) { vm->stack.push(vm->frames[vm->count - 1].slots[operand]); return 0; }
+        static int jit_assignment_local(VM* vm, uint32_t operand) { vm->frames[vm->count - 1].slots[operand] = vm->stack.top(); return 0; }
+
+        static int jit_counter(VM* vm, uint32_t operand) {
+            Value* counter = &vm->frames[vm->count - 1].slots[operand];
+            vm->stack.push(Number::INTEGER(counter->value.integer));
+            return 0;
+        }
+
+        static int jit_condition(VM* vm, uint32_t /*operand*/) {
+            if(vm->stack.top().index() != VAL_BOOLEAN) return 2;
+            return vm->stack.top().value.boolean.boolean ? 1 : 0;
+        }
+
+        static int jit_range_loop(VM* vm, uint32_t operand) {
+            Value* counter = &vm->frames[vm->count - 1].slots[operand];
+            return ++counter[0].value.integer < counter[1].value.integer;
+        }
+
+        static int jit_pop(VM* vm, uint32_t /*operand*/) { vm->stack.pop(); return 0; }
+        static int jit_empty(VM* /*vm*/, uint32_t /*operand*/) { return 0; }
+
+        bool prepare(Value constant) {
+            if(constant.index() != VAL_FUNCTION || constant.value.function.chunk->lazy == nullptr) return true;
+            return this->parser.resume(&constant.value.function);
+        }
+
+        bool tail(Value constant, int arguments) {
+            Frame* frame = &this->frames[this->count - 1];
+
+            if(constant.value.function.parameters != arguments) { this->runtime(ARGUMENTS_ERROR); return false; }
+
+            Value* callee = this->stack.topper - arguments - 1;
+
+            PROBE1(function__return, frame->function->name.c_str());
+
+            frame->slots[-1] = constant;
+            for(int i = 0; i < arguments; i++) frame->slots[i] = callee[i + 1];
+
+            this->stack.topper = frame->slots + arguments;
+
+            frame->function = &frame->slots[-1].value.function;
+            frame->pc = &(frame->function->chunk->codes.front());
+
+            if(this->fits(frame) == false) { this->runtime(STACK_OVERFLOW_ERROR); return false; }
+
+            PROBE2(function__entry, frame->function->name.c_str(), arguments);
+
+            return true;
+        }
+
         Interpret runtime(RUN_TIME_ERROR error) {
             std::string message = run_time_error.find(error)->second;
+            PROBE2(runtime__error, message.c_str(), this->line(&this->frames[this->count - 1]));
 
             for(int i = this->count - 1; i >= 0; i--) {                 
                 Frame* frame = &this->frames[i];                            
                 Function* function = frame->function;                                                                   
-                size_t instruction = frame->pc - &(function->chunk->codes.front()) - 1;   
-                fprintf(stderr, "[line %d] ", function->chunk->lines[instruction]);  
+
+                fprintf(stderr, "[line %d] ", this->line(frame));  
 
                 if(i == 0) fprintf(stderr, "RUN-TIME ERROR in script: ");                                                                                  
                 else fprintf(stderr, "in `%s` ->\n", function->name.c_str());
@@ -380,4 +1142,7 @@ class VM {
         }
 };
 
+VM* VM::sampled = nullptr;
+VM* VM::current = nullptr;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,30 @@
+#!/bin/sh
+# Runs every tests/*.mag on each execution tier and compares its output and exit code with tests/<name>.out
+
+cd "$(dirname "$0")/.." || exit 1
+
+BUILD=$(mktemp -d)
+trap 'rm -rf "$BUILD"' EXIT
+
+CXX=${CXX:-g++}
+$CXX -std=c++17 -O2 -o "$BUILD/magnum" magnum.cpp || exit 1
+
+failures=0
+
+for script in tests/*.mag; do
+    name=$(basename "$script" .mag)
+
+    for mode in "" --registers --jit --lazy --emit-cpp; do
+        if [ "$mode" = "--emit-cpp" ]; then
+            "$BUILD/magnum" --emit-cpp "$script" > "$BUILD/$name.cpp" && $CXX -std=c++17 -O1 -w -I src -o "$BUILD/$name" "$BUILD/$name.cpp" || { echo "FAIL $name $mode (build)"; failures=$((failures + 1)); continue; }
+            output=$("$BUILD/$name" 2>&1; printf "\nexit %d" $?)
+        else
+            output=$("$BUILD/magnum" --no-cache $mode "$script" 2>&1; printf "\nexit %d" $?)
+        fi
+
+        if [ "$output" = "$(cat "tests/$name.out")" ]; then echo "ok   $name $mode"
+        else echo "FAIL $name $mode"; failures=$((failures + 1)); fi
+    done
+done
+
+[ $failures -eq 0 ]